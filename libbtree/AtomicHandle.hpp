@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+// A trivially copyable value (e.g. the root's uid) that is read and swapped atomically without a lock on the read side.
+// std::atomic would fall back to a lock (or to a read-modify-write) for values wider than a word, so the value is kept in
+// word-sized atomics guarded by a version counter instead: a writer makes the counter odd while it rewrites the words,
+// and a reader retries until it has copied them out between two equal, even samples. Readers thus never write the
+// shared cache line, and a reader that samples the version can later validate that the value has not been swapped since.
+template <typename ValueType>
+class AtomicHandle
+{
+	static_assert(std::is_trivially_copyable<ValueType>::value, "AtomicHandle is limited to trivially copyable types");
+
+private:
+	static constexpr size_t WORDS = (sizeof(ValueType) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	std::atomic<uint64_t> m_nVersion;
+	std::atomic<uint64_t> m_vtWords[WORDS];
+
+public:
+	AtomicHandle()
+		: m_nVersion(0)
+	{
+		for (size_t nIdx = 0; nIdx < WORDS; nIdx++)
+		{
+			m_vtWords[nIdx].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	AtomicHandle(const AtomicHandle&) = delete;
+	AtomicHandle& operator=(const AtomicHandle&) = delete;
+
+	inline ValueType load() const
+	{
+		ValueType value;
+		uint64_t nVersion;
+
+		while (!tryLoad(value, nVersion))
+		{
+			std::this_thread::yield();
+		}
+
+		return value;
+	}
+
+	// Copies the value out along with the version it was read at; fails if a writer got in the way.
+	inline bool tryLoad(ValueType& value, uint64_t& nVersion) const
+	{
+		nVersion = m_nVersion.load(std::memory_order_acquire);
+		if ((nVersion & 1) != 0)
+		{
+			return false;
+		}
+
+		readWords(value);
+
+		return validate(nVersion);
+	}
+
+	// Whether the value loaded at 'nVersion' is still the current one.
+	inline bool validate(uint64_t nVersion) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return m_nVersion.load(std::memory_order_relaxed) == nVersion;
+	}
+
+	inline void store(const ValueType& value)
+	{
+		uint64_t nVersion = acquire();
+		writeWords(value);
+		m_nVersion.store(nVersion + 2, std::memory_order_release);
+	}
+
+	// Replaces the value only if it still equals 'expected'.
+	inline bool compareExchange(const ValueType& expected, const ValueType& desired)
+	{
+		uint64_t nVersion = acquire();
+
+		ValueType current;
+		readWords(current);
+
+		bool bSwapped = (current == expected);
+		if (bSwapped)
+		{
+			writeWords(desired);
+		}
+
+		m_nVersion.store(nVersion + 2, std::memory_order_release);
+
+		return bSwapped;
+	}
+
+private:
+	// Makes the version odd, which both excludes the other writers and turns the readers away.
+	inline uint64_t acquire()
+	{
+		uint64_t nVersion = m_nVersion.load(std::memory_order_relaxed);
+
+		do
+		{
+			if ((nVersion & 1) != 0)
+			{
+				std::this_thread::yield();
+				nVersion = m_nVersion.load(std::memory_order_relaxed);
+				continue;
+			}
+
+			if (m_nVersion.compare_exchange_weak(nVersion, nVersion + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				break;
+			}
+		} while (true);
+
+		std::atomic_thread_fence(std::memory_order_release);
+
+		return nVersion;
+	}
+
+	inline void readWords(ValueType& value) const
+	{
+		uint64_t vtWords[WORDS];
+		for (size_t nIdx = 0; nIdx < WORDS; nIdx++)
+		{
+			vtWords[nIdx] = m_vtWords[nIdx].load(std::memory_order_relaxed);
+		}
+
+		std::memcpy(&value, vtWords, sizeof(ValueType));
+	}
+
+	inline void writeWords(const ValueType& value)
+	{
+		uint64_t vtWords[WORDS] = {};
+		std::memcpy(vtWords, &value, sizeof(ValueType));
+
+		for (size_t nIdx = 0; nIdx < WORDS; nIdx++)
+		{
+			m_vtWords[nIdx].store(vtWords[nIdx], std::memory_order_relaxed);
+		}
+	}
+};
@@ -11,8 +11,16 @@
 #include <exception>
 #include <variant>
 #include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
 #include "CacheErrorCodes.h"
 #include "ErrorCodes.h"
+#include "Prefetch.h"
+#include "AtomicHandle.hpp"
+#include "VersionedSharedMutex.hpp"
 #include "VariadicNthType.h"
 #include <tuple>
 
@@ -22,6 +30,14 @@
 
 #define __CONCURRENT__
 //#define __TREE_AWARE_CACHE__
+//#define __BLINK_TREE__
+
+#if defined(__BLINK_TREE__) && defined(__TREE_AWARE_CACHE__)
+#error "The B-link mode does not follow the relocation of the index nodes' right links, hence it requires every node to stay resident."
+#endif
+
+// Optimistic attempts a search makes before it takes the locks along its path.
+#define OPTIMISTIC_SEARCH_ATTEMPTS 8
 
 #ifdef __TREE_AWARE_CACHE__
 template <typename ICallback, typename KeyType, typename ValueType, typename CacheType>
@@ -41,21 +57,35 @@ class BPlusStore
 private:
     uint32_t m_nDegree;
     std::shared_ptr<CacheType> m_ptrCache;
-    std::optional<ObjectUIDType> m_uidRootNode;
+
+    // There is no tree-wide lock; an operation latches the root node itself (see lockRootNode), and the root is only
+    // replaced while its latch is held exclusively, or, in the B-link mode, by a compare-and-swap on this handle.
+    AtomicHandle<ObjectUIDType> m_uidRootNode;
+
+    // Bumped by every split, merge or redistribution so that cursors can tell whether the leaf they pin still covers their key.
+    std::atomic<size_t> m_nStructureVersion;
+
+#ifdef __TREE_AWARE_CACHE__
+    // Leaves relocated by prepareFlush while a neighbour outside the batch still links to them:
+    // old uid -> (new uid, number of sibling links that still hold the old uid).
+    std::unordered_map<ObjectUIDType, std::pair<ObjectUIDType, size_t>> m_mpSiblingUIDUpdates;
 
 #ifdef __CONCURRENT__
-    mutable std::shared_mutex m_mutex;
+    std::mutex m_mtxSiblingUIDUpdates;
 #endif __CONCURRENT__
+#endif __TREE_AWARE_CACHE__
 
 public:
     ~BPlusStore()
     {
+        // The cache's flush thread calls back into the tree, hence the cache is shut down before the members it uses.
+        m_ptrCache = nullptr;
     }
 
     template<typename... CacheArgs>
     BPlusStore(uint32_t nDegree, CacheArgs... args)
         : m_nDegree(nDegree)
-        , m_uidRootNode(std::nullopt)
+        , m_nStructureVersion(0)
     {
         m_ptrCache = std::make_shared<CacheType>(args...);
     }
@@ -67,71 +97,110 @@ public:
         m_ptrCache->init(this);
 #endif __TREE_AWARE_CACHE__
 
-        m_ptrCache->template createObjectOfType<DefaultNodeType>(m_uidRootNode);
+        std::optional<ObjectUIDType> uidRootNode = std::nullopt;
+        m_ptrCache->template createObjectOfType<DefaultNodeType>(uidRootNode);
+
+        m_uidRootNode.store(*uidRootNode);
     }
 
-    ErrorCode insert(const KeyType& key, const ValueType& value)
+    // Builds the tree bottom-up from entries sorted by key in strictly ascending order, instead of inserting them one by
+    // one. Each node is filled up to 'nFillFactor' of its capacity so that some room is left for later inserts. The store
+    // must be empty, i.e. init() has been called and nothing has been inserted since.
+    template <typename InputIterator>
+    ErrorCode bulkLoad(InputIterator itBegin, InputIterator itEnd, float nFillFactor = 1.0f)
     {
-        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+        std::vector<KeyType> vtKeys;
+        std::vector<ValueType> vtValues;
 
-#ifdef __CONCURRENT__
-        std::vector<std::unique_lock<std::shared_mutex>> vtLocks;
-#endif __CONCURRENT__
+        for (InputIterator it = itBegin; it != itEnd; it++)
+        {
+            if (vtKeys.size() > 0 && !(vtKeys.back() < (*it).first))
+            {
+                return ErrorCode::Error;
+            }
 
-        ObjectUIDType uidLastNode, uidCurrentNode;  // TODO: make Optional!
-        ObjectTypePtr ptrLastNode = nullptr, ptrCurrentNode = nullptr;
+            vtKeys.push_back((*it).first);
+            vtValues.push_back((*it).second);
+        }
 
-        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtNodes;
+        ObjectUIDType uidRootNode;
+        ObjectTypePtr ptrRootNode = nullptr;
 
 #ifdef __CONCURRENT__
-        vtLocks.push_back(std::unique_lock<std::shared_mutex>(m_mutex));
+        std::vector<std::unique_lock<VersionedSharedMutex>> vtLocks;
+        lockRootNode(uidRootNode, ptrRootNode, vtLocks);
+#else __CONCURRENT__
+        getRootNode(uidRootNode, ptrRootNode);
 #endif __CONCURRENT__
 
-        uidCurrentNode = m_uidRootNode.value();
+        if (!std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrRootNode->data)
+            || std::get<std::shared_ptr<DataNodeType>>(*ptrRootNode->data)->getKeysCount() > 0)
+        {
+            return ErrorCode::Error;
+        }
 
-        do
+        if (vtKeys.size() == 0)
         {
-#ifdef __TREE_AWARE_CACHE__
-            std::optional<ObjectUIDType> uidUpdated = std::nullopt;
-            m_ptrCache->getObject(uidCurrentNode, ptrCurrentNode, uidUpdated);    //TODO: lock
+            return ErrorCode::Success;
+        }
 
-            if (uidUpdated != std::nullopt)
-            {
-                if (ptrLastNode != nullptr)
-                {
-                    if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrLastNode->data))
-                    {
-                        std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrLastNode->data);
-                        ptrIndexNode->updateChildUID(uidCurrentNode, *uidUpdated);
-                        ptrLastNode->dirty = true;
-                    }
-                    else //if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrLastNode->data))
-                    {
-                        throw new std::exception("should not occur!");
-                    }
-                }
-                else
-                {
-                    //ptrLastNode->dirty = true; do ths ame for root!
-                    assert(uidCurrentNode == *m_uidRootNode);
-                    m_uidRootNode = uidUpdated;
-                }
+        ptrRootNode = nullptr;
 
-                uidCurrentNode = *uidUpdated;
-            }
+        // Shape of the tree, bottom-up: the number of entries per leaf followed by the number of children per index node.
+        std::vector<std::vector<size_t>> vtLevels;
+        vtLevels.push_back(getBulkLoadPartitions(vtKeys.size(), m_nDegree, 1, nFillFactor));
+
+        while (vtLevels.back().size() > 1)
+        {
+            vtLevels.push_back(getBulkLoadPartitions(vtLevels.back().size(), m_nDegree + 1, 2, nFillFactor));
+        }
+
+        std::optional<ObjectUIDType> uidNewRootNode = std::nullopt;
+
+#ifdef __TREE_AWARE_CACHE__
+        bulkLoadToStorage(vtKeys, vtValues, vtLevels, uidNewRootNode);
 #else __TREE_AWARE_CACHE__
-            m_ptrCache->getObject(uidCurrentNode, ptrCurrentNode);    //TODO: lock
+        bulkLoadToCache(vtKeys, vtValues, vtLevels, uidNewRootNode);
 #endif __TREE_AWARE_CACHE__
 
+        m_uidRootNode.store(*uidNewRootNode);
+
 #ifdef __CONCURRENT__
-            vtLocks.push_back(std::unique_lock<std::shared_mutex>(ptrCurrentNode->mutex));
+        vtLocks.clear();
 #endif __CONCURRENT__
 
-            if (ptrCurrentNode == nullptr)
-            {
-                throw new std::exception("should not occur!");   // TODO: critical log.
-            }
+        m_ptrCache->remove(uidRootNode);
+
+        m_nStructureVersion++;
+
+        return ErrorCode::Success;
+    }
+
+    ErrorCode insert(const KeyType& key, const ValueType& value)
+    {
+#ifdef __BLINK_TREE__
+        return insertBLink(key, value);
+#endif __BLINK_TREE__
+
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+
+#ifdef __CONCURRENT__
+        std::vector<std::unique_lock<VersionedSharedMutex>> vtLocks;
+#endif __CONCURRENT__
+
+        ObjectUIDType uidLastNode, uidCurrentNode;  // TODO: make Optional!
+        ObjectTypePtr ptrLastNode = nullptr, ptrCurrentNode = nullptr;
 
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtNodes;
+
+#ifdef __CONCURRENT__
+        lockRootNode(uidCurrentNode, ptrCurrentNode, vtLocks);
+#else __CONCURRENT__
+        getRootNode(uidCurrentNode, ptrCurrentNode);
+#endif __CONCURRENT__
+
+        do
+        {
             vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
 
             if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data))
@@ -154,6 +223,12 @@ public:
                 ptrLastNode = ptrCurrentNode;
 
                 uidCurrentNode = ptrIndexNode->getChild(key);
+
+                getChildNode(ptrLastNode, uidCurrentNode, ptrCurrentNode);
+
+#ifdef __CONCURRENT__
+                vtLocks.push_back(std::unique_lock<VersionedSharedMutex>(ptrCurrentNode->mutex));
+#endif __CONCURRENT__
             }
             else if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data))
             {
@@ -194,6 +269,11 @@ public:
         ObjectUIDType uidLHSNode;
         std::optional<ObjectUIDType> uidRHSNode;
 
+        if (vtNodes.size() > 0)
+        {
+            m_nStructureVersion++;
+        }
+
         while (vtNodes.size() > 0)
         {
             std::pair<ObjectUIDType, ObjectTypePtr> prNodeDetails = vtNodes.back();
@@ -205,7 +285,11 @@ public:
                     throw new std::exception("should not occur!");
                 }
 
-                m_ptrCache->template createObjectOfType<IndexNodeType>(m_uidRootNode, pivotKey, uidLHSNode, *uidRHSNode);
+                // The old root is still latched, hence the tree grows by a level before anyone else gets to it.
+                std::optional<ObjectUIDType> uidRootNode = std::nullopt;
+                m_ptrCache->template createObjectOfType<IndexNodeType>(uidRootNode, pivotKey, uidLHSNode, *uidRHSNode);
+
+                m_uidRootNode.store(*uidRootNode);
 
                 int idx = 0;
                 auto it_a = vtAccessedNodes.begin();
@@ -272,7 +356,9 @@ public:
             {
                 std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*prNodeDetails.second->data);
 
-                ErrorCode errCode = ptrDataNode->template split<std::shared_ptr<CacheType>, ObjectUIDType>(m_ptrCache, uidRHSNode, pivotKey);
+                std::optional<ObjectUIDType> uidNextSibling = ptrDataNode->getNextSibling();
+
+                ErrorCode errCode = ptrDataNode->template split<std::shared_ptr<CacheType>, ObjectUIDType>(m_ptrCache, prNodeDetails.first, uidRHSNode, pivotKey);
 
                 if (errCode != ErrorCode::Success)
                 {
@@ -280,6 +366,13 @@ public:
                     throw new std::exception("should not occur!"); // for the time being!
                 }
 
+#ifdef __TREE_AWARE_CACHE__
+                // The address of a released leaf may have been reused for the new one.
+                discardSiblingUIDUpdate(*uidRHSNode);
+#endif __TREE_AWARE_CACHE__
+
+                relinkPrevSibling(pivotKey, uidNextSibling, *uidRHSNode);
+
 #ifdef __TREE_AWARE_CACHE__
                 prNodeDetails.second->dirty = true;
 #endif __TREE_AWARE_CACHE__
@@ -300,70 +393,63 @@ public:
     {
         ErrorCode errCode = ErrorCode::Error;
 
-        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
-
 #ifdef __CONCURRENT__
-        std::vector<std::shared_lock<std::shared_mutex>> vtLocks;
-        vtLocks.push_back(std::shared_lock<std::shared_mutex>(m_mutex));
-#endif __CONCURRENT__
-
-        ObjectUIDType uidCurrentNode = *m_uidRootNode;
-        do
+        // Torn reads are discarded once validation fails, but they must not be able to crash the reader.
+        if constexpr (std::is_trivially_copyable_v<KeyType> && std::is_trivially_copyable_v<ValueType>)
         {
-            ObjectTypePtr prNodeDetails = nullptr;
-
-#ifdef __TREE_AWARE_CACHE__
-            std::optional<ObjectUIDType> uidUpdated = std::nullopt;
-            m_ptrCache->getObject(uidCurrentNode, prNodeDetails, uidUpdated);    //TODO: lock
-
-            if (uidUpdated != std::nullopt)
+            for (size_t nAttempt = 0; nAttempt < OPTIMISTIC_SEARCH_ATTEMPTS; nAttempt++)
             {
-                ObjectTypePtr ptrLastNode = vtAccessedNodes.size() > 0 ? vtAccessedNodes[vtAccessedNodes.size() - 1].second : nullptr;
-                if (ptrLastNode != nullptr)
+                bool bResident = true;
+                if (searchOptimistic(key, value, errCode, bResident))
                 {
-                    if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrLastNode->data))
-                    {
-                        std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrLastNode->data);
-                        ptrIndexNode->updateChildUID(uidCurrentNode, *uidUpdated);
-
-                        ptrLastNode->dirty = true;
-                    }
-                    else //if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrLastNode->data))
-                    {
-                        throw new std::exception("should not occur!");
-                    }
+                    return errCode;
                 }
-                else
+
+                if (!bResident)
                 {
-                    //ptrLastNode->dirty = true;  do the same thing here... atm root never leaves cache. but later fix this.
-                    assert(uidCurrentNode == *m_uidRootNode);
-                    m_uidRootNode = uidUpdated;
+                    break;
                 }
-
-                uidCurrentNode = *uidUpdated;
             }
-#else __TREE_AWARE_CACHE__
-            m_ptrCache->getObject(uidCurrentNode, prNodeDetails);    //TODO: lock
-#endif __TREE_AWARE_CACHE__
+        }
+#endif __CONCURRENT__
+
+#ifdef __BLINK_TREE__
+        return searchBLink(key, value);
+#endif __BLINK_TREE__
 
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
 
 #ifdef __CONCURRENT__
-            vtLocks.push_back(std::shared_lock<std::shared_mutex>(prNodeDetails->mutex));
-            vtLocks.erase(vtLocks.begin());
+        std::vector<std::shared_lock<VersionedSharedMutex>> vtLocks;
 #endif __CONCURRENT__
 
-            if (prNodeDetails == nullptr)
-            {
-                throw new std::exception("should not occur!");
-            }
+        ObjectUIDType uidCurrentNode;
+        ObjectTypePtr prNodeDetails = nullptr;
 
+#ifdef __CONCURRENT__
+        lockRootNode(uidCurrentNode, prNodeDetails, vtLocks);
+#else __CONCURRENT__
+        getRootNode(uidCurrentNode, prNodeDetails);
+#endif __CONCURRENT__
+
+        do
+        {
             vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, prNodeDetails));
 
             if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*prNodeDetails->data))
             {
                 std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*prNodeDetails->data);
 
+                ObjectTypePtr ptrLastNode = prNodeDetails;
+
                 uidCurrentNode = ptrIndexNode->getChild(key);
+
+                getChildNode(ptrLastNode, uidCurrentNode, prNodeDetails);
+
+#ifdef __CONCURRENT__
+                vtLocks.push_back(std::shared_lock<VersionedSharedMutex>(prNodeDetails->mutex));
+                vtLocks.erase(vtLocks.begin());
+#endif __CONCURRENT__
             }
             else if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*prNodeDetails->data))
             {
@@ -383,69 +469,252 @@ public:
         return errCode;
     }
 
-    ErrorCode remove(const KeyType& key)
-    {   
+    // Looks up a batch of keys by walking them down the tree level by level in lockstep. The keys are probed in ascending
+    // order, so the lookups that pass through the same node share its fetch and its lock, and the nodes of a level are all
+    // fetched and prefetched before any of them is searched. vtValues and vtCodes receive the outcome for each key.
+    ErrorCode searchBatch(const std::vector<KeyType>& vtKeys, std::vector<ValueType>& vtValues, std::vector<ErrorCode>& vtCodes)
+    {
+        ErrorCode errCode = ErrorCode::Success;
+
+        vtValues.resize(vtKeys.size());
+        vtCodes.assign(vtKeys.size(), ErrorCode::Error);
+
+        if (vtKeys.size() == 0)
+        {
+            return errCode;
+        }
+
+        std::vector<size_t> vtOrder(vtKeys.size());
+        std::iota(vtOrder.begin(), vtOrder.end(), 0);
+
+        if (!std::is_sorted(vtKeys.begin(), vtKeys.end()))
+        {
+            std::stable_sort(vtOrder.begin(), vtOrder.end(), [&vtKeys](size_t lhs, size_t rhs)
+                {
+                    return vtKeys[lhs] < vtKeys[rhs];
+                });
+        }
+
         std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
 
-#ifdef __CONCURRENT__
-        std::vector<std::unique_lock<std::shared_mutex>> vtLocks;
-#endif __CONCURRENT__
+        // The nodes of the current level, the range of vtOrder that passes through each, and the index of their parents in
+        // the level above.
+        std::vector<ObjectUIDType> vtUIDs;
+        std::vector<ObjectTypePtr> vtNodes, vtParentNodes;
+        std::vector<std::pair<size_t, size_t>> vtRanges;
+        std::vector<size_t> vtParents;
 
-        ObjectUIDType uidLastNode, uidCurrentNode;
-        ObjectTypePtr ptrLastNode = nullptr, ptrCurrentNode = nullptr;
+#ifdef __BLINK_TREE__
+        // The keys that lie beyond the high key of a node on their way down, i.e. that have been moved to the right by a
+        // split which raced the descent; they are looked up one by one once the batch is done.
+        std::vector<size_t> vtDeferred;
+#endif __BLINK_TREE__
 
-        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtNodes;
+        ObjectUIDType uidRootNode;
+        ObjectTypePtr ptrRootNode = nullptr;
 
 #ifdef __CONCURRENT__
-        vtLocks.push_back(std::unique_lock<std::shared_mutex>(m_mutex));
+        std::vector<std::shared_lock<VersionedSharedMutex>> vtLocks;
+        lockRootNode(uidRootNode, ptrRootNode, vtLocks);
+#else __CONCURRENT__
+        getRootNode(uidRootNode, ptrRootNode);
 #endif __CONCURRENT__
 
-        uidCurrentNode = m_uidRootNode.value();
+        vtUIDs.push_back(uidRootNode);
+        vtRanges.push_back(std::make_pair(0, vtOrder.size()));
+        vtParents.push_back(0);
 
-        do
+        while (vtUIDs.size() > 0)
         {
 #ifdef __TREE_AWARE_CACHE__
-            std::optional<ObjectUIDType> uidUpdated = std::nullopt;
-            m_ptrCache->getObject(uidCurrentNode, ptrCurrentNode, uidUpdated);    //TODO: lock
+            std::vector<std::optional<ObjectUIDType>> vtUpdatedUIDs;
+            m_ptrCache->getObjects(vtUIDs, vtNodes, vtUpdatedUIDs);
 
-            if (uidUpdated != std::nullopt)
+            for (size_t nIdx = 0; nIdx < vtUIDs.size(); nIdx++)
             {
-                if (ptrLastNode != nullptr)
+                if (vtUpdatedUIDs[nIdx] == std::nullopt)
                 {
-                    if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrLastNode->data))
-                    {
-                        std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrLastNode->data);
-                        ptrIndexNode->updateChildUID(uidCurrentNode, *uidUpdated);
-                        ptrLastNode->dirty = true;
-                    }
-                    else //if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrLastNode->data))
-                    {
-                        throw new std::exception("should not occur!");
-                    }
+                    continue;
+                }
+
+                if (vtParentNodes.size() == 0)
+                {
+                    m_uidRootNode.compareExchange(vtUIDs[nIdx], *vtUpdatedUIDs[nIdx]);
                 }
                 else
                 {
-                    // ptrLastNode->dirty = true; todo: do for parent as well..
-                    assert(uidCurrentNode == *m_uidRootNode);
-                    m_uidRootNode = uidUpdated;
+                    ObjectTypePtr ptrParentNode = vtParentNodes[vtParents[nIdx]];
+
+                    std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrParentNode->data);
+                    ptrIndexNode->updateChildUID(vtUIDs[nIdx], *vtUpdatedUIDs[nIdx]);
+
+                    ptrParentNode->dirty = true;
                 }
 
-                uidCurrentNode = *uidUpdated;
+                vtUIDs[nIdx] = *vtUpdatedUIDs[nIdx];
             }
 #else __TREE_AWARE_CACHE__
-            m_ptrCache->getObject(uidCurrentNode, ptrCurrentNode);    //TODO: lock
+            m_ptrCache->getObjects(vtUIDs, vtNodes);
 #endif __TREE_AWARE_CACHE__
 
+            for (size_t nIdx = 0; nIdx < vtNodes.size(); nIdx++)
+            {
+                if (vtNodes[nIdx] == nullptr)
+                {
+                    throw new std::exception("should not occur!");
+                }
+
+                PREFETCH(&*vtNodes[nIdx]);
+            }
 
 #ifdef __CONCURRENT__
-            vtLocks.push_back(std::unique_lock<std::shared_mutex>(ptrCurrentNode->mutex));
+            // The root has been latched up front.
+            if (vtParentNodes.size() > 0)
+            {
+                std::vector<std::shared_lock<VersionedSharedMutex>> vtLevelLocks;
+                for (size_t nIdx = 0; nIdx < vtNodes.size(); nIdx++)
+                {
+                    vtLevelLocks.push_back(std::shared_lock<VersionedSharedMutex>(vtNodes[nIdx]->mutex));
+                }
+
+                // The level above is released only once this one is held.
+                vtLocks = std::move(vtLevelLocks);
+            }
 #endif __CONCURRENT__
 
-            if (ptrCurrentNode == nullptr)
+            for (size_t nIdx = 0; nIdx < vtNodes.size(); nIdx++)
             {
-                throw new std::exception("should not occur!");
+                PREFETCH(&*vtNodes[nIdx]->data);
+            }
+
+            for (size_t nIdx = 0; nIdx < vtNodes.size(); nIdx++)
+            {
+                if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*vtNodes[nIdx]->data))
+                {
+                    std::get<std::shared_ptr<IndexNodeType>>(*vtNodes[nIdx]->data)->prefetch();
+                }
+                else
+                {
+                    std::get<std::shared_ptr<DataNodeType>>(*vtNodes[nIdx]->data)->prefetch();
+                }
+            }
+
+            std::vector<ObjectUIDType> vtChildUIDs;
+            std::vector<std::pair<size_t, size_t>> vtChildRanges;
+            std::vector<size_t> vtChildParents;
+
+            for (size_t nIdx = 0; nIdx < vtNodes.size(); nIdx++)
+            {
+                vtAccessedNodes.push_back(std::make_pair(vtUIDs[nIdx], vtNodes[nIdx]));
+
+                if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*vtNodes[nIdx]->data))
+                {
+                    std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*vtNodes[nIdx]->data);
+
+                    size_t nChildIdx = 0;
+                    for (size_t nPos = vtRanges[nIdx].first; nPos < vtRanges[nIdx].second; nPos++)
+                    {
+#ifdef __BLINK_TREE__
+                        if (getRightLink(vtNodes[nIdx], vtKeys[vtOrder[nPos]]))
+                        {
+                            vtDeferred.insert(vtDeferred.end(), vtOrder.begin() + nPos, vtOrder.begin() + vtRanges[nIdx].second);
+                            break;
+                        }
+#endif __BLINK_TREE__
+
+                        size_t nLastChildIdx = nChildIdx;
+                        nChildIdx = ptrIndexNode->getChildNodeIdx(vtKeys[vtOrder[nPos]], nChildIdx);
+
+                        if (nPos > vtRanges[nIdx].first && nChildIdx == nLastChildIdx)
+                        {
+                            vtChildRanges.back().second++;
+                            continue;
+                        }
+
+                        vtChildUIDs.push_back(ptrIndexNode->getChildAt(nChildIdx));
+                        vtChildRanges.push_back(std::make_pair(nPos, nPos + 1));
+                        vtChildParents.push_back(nIdx);
+                    }
+                }
+                else if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*vtNodes[nIdx]->data))
+                {
+                    std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*vtNodes[nIdx]->data);
+
+                    for (size_t nPos = vtRanges[nIdx].first; nPos < vtRanges[nIdx].second; nPos++)
+                    {
+#ifdef __BLINK_TREE__
+                        if (getRightLink(vtNodes[nIdx], vtKeys[vtOrder[nPos]]))
+                        {
+                            vtDeferred.insert(vtDeferred.end(), vtOrder.begin() + nPos, vtOrder.begin() + vtRanges[nIdx].second);
+                            break;
+                        }
+#endif __BLINK_TREE__
+
+                        size_t nKeyIdx = vtOrder[nPos];
+                        vtCodes[nKeyIdx] = ptrDataNode->getValue(vtKeys[nKeyIdx], vtValues[nKeyIdx]);
+
+                        if (vtCodes[nKeyIdx] != ErrorCode::Success)
+                        {
+                            errCode = ErrorCode::KeyDoesNotExist;
+                        }
+                    }
+                }
+            }
+
+            vtParentNodes.swap(vtNodes);
+            vtUIDs.swap(vtChildUIDs);
+            vtRanges.swap(vtChildRanges);
+            vtParents.swap(vtChildParents);
+        }
+
+        // The nodes were gathered level by level, hence every parent ends up ahead of its children. A batch may touch more
+        // nodes than the cache holds, so the ones evicted meanwhile are skipped.
+        m_ptrCache->reorder(vtAccessedNodes, false);
+
+#ifdef __BLINK_TREE__
+#ifdef __CONCURRENT__
+        vtLocks.clear();
+#endif __CONCURRENT__
+
+        for (auto it = vtDeferred.begin(); it != vtDeferred.end(); it++)
+        {
+            vtCodes[*it] = search(vtKeys[*it], vtValues[*it]);
+
+            if (vtCodes[*it] != ErrorCode::Success)
+            {
+                errCode = ErrorCode::KeyDoesNotExist;
             }
+        }
+#endif __BLINK_TREE__
+
+        return errCode;
+    }
+
+    ErrorCode remove(const KeyType& key)
+    {   
+#ifdef __BLINK_TREE__
+        return removeBLink(key);
+#endif __BLINK_TREE__
+
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+
+#ifdef __CONCURRENT__
+        std::vector<std::unique_lock<VersionedSharedMutex>> vtLocks;
+#endif __CONCURRENT__
+
+        ObjectUIDType uidLastNode, uidCurrentNode;
+        ObjectTypePtr ptrLastNode = nullptr, ptrCurrentNode = nullptr;
+
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtNodes;
 
+#ifdef __CONCURRENT__
+        lockRootNode(uidCurrentNode, ptrCurrentNode, vtLocks);
+#else __CONCURRENT__
+        getRootNode(uidCurrentNode, ptrCurrentNode);
+#endif __CONCURRENT__
+
+        do
+        {
             vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
 
             if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data))
@@ -471,6 +740,12 @@ public:
                 ptrLastNode = ptrCurrentNode;
 
                 uidCurrentNode = ptrIndexNode->getChild(key); // fid it.. there are two kinds of methods..
+
+                getChildNode(ptrLastNode, uidCurrentNode, ptrCurrentNode);
+
+#ifdef __CONCURRENT__
+                vtLocks.push_back(std::unique_lock<VersionedSharedMutex>(ptrCurrentNode->mutex));
+#endif __CONCURRENT__
             }
             else if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data))
             {
@@ -505,6 +780,11 @@ public:
         ObjectUIDType uidChildNode;
         ObjectTypePtr ptrChildNode = nullptr;
 
+        if (vtNodes.size() > 0)
+        {
+            m_nStructureVersion++;
+        }
+
         while (vtNodes.size() > 0)
         {
             std::pair<ObjectUIDType, ObjectTypePtr> prNodeDetails = vtNodes.back();
@@ -516,7 +796,9 @@ public:
                     throw new std::exception("should not occur!");
                 }
 
-                if (*m_uidRootNode != uidChildNode)
+                ObjectUIDType uidCurrentRoot = m_uidRootNode.load();
+
+                if (uidCurrentRoot != uidChildNode)
                 {
                     throw new std::exception("should not occur!");
                 }
@@ -525,29 +807,44 @@ public:
 
 #ifdef __TREE_AWARE_CACHE__
                 std::optional<ObjectUIDType> uidUpdated = std::nullopt;
-                m_ptrCache->getObject(*m_uidRootNode, ptrCurrentRoot, uidUpdated);
+                m_ptrCache->getObject(uidCurrentRoot, ptrCurrentRoot, uidUpdated);
 
                 assert(uidUpdated == std::nullopt);
 
                 ptrCurrentRoot->dirty = true;
 #else __TREE_AWARE_CACHE__
-                m_ptrCache->getObject(*m_uidRootNode, ptrCurrentRoot);
+                m_ptrCache->getObject(uidCurrentRoot, ptrCurrentRoot);
 #endif __TREE_AWARE_CACHE__
 
                 if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrCurrentRoot->data))
                 {
                     std::shared_ptr<IndexNodeType> ptrInnerNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrCurrentRoot->data);
                     if (ptrInnerNode->getKeysCount() == 0) {
-                        ObjectUIDType _tmp = ptrInnerNode->getChildAt(0);
-                        m_ptrCache->remove(*m_uidRootNode);
-                        m_uidRootNode = _tmp;
+                        // The root is still latched; the threads waiting for it find it replaced and start over.
+                        m_uidRootNode.store(ptrInnerNode->getChildAt(0));
 
-#ifdef __TREE_AWARE_CACHE__
-                        ptrCurrentRoot->dirty = true;
-#endif __TREE_AWARE_CACHE__
-                    }
-                }
-                else if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrCurrentRoot->data))
+#ifdef __CONCURRENT__
+                        auto it = vtLocks.begin();
+                        while (it != vtLocks.end()) {
+                            if ((*it).mutex() == &ptrCurrentRoot->mutex)
+                            {
+                                break;
+                            }
+                            it++;
+                        }
+
+                        if (it != vtLocks.end())
+                            vtLocks.erase(it);
+#endif __CONCURRENT__
+
+                        m_ptrCache->remove(uidCurrentRoot);
+
+#ifdef __TREE_AWARE_CACHE__
+                        ptrCurrentRoot->dirty = true;
+#endif __TREE_AWARE_CACHE__
+                    }
+                }
+                else if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrCurrentRoot->data))
                 {
                     int i = 0;
                     /*std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentRoot->data);
@@ -616,6 +913,17 @@ public:
 
                     if (uidToDelete)
                     {
+                        // Either the LHS sibling absorbed the child or the child absorbed the RHS sibling;
+                        // in both cases the child's next link now names the leaf that follows the survivor.
+                        if (*uidToDelete == uidChildNode)
+                        {
+                            relinkPrevSibling(key, ptrChildDataNode->getNextSibling(), *ptrChildDataNode->getPrevSibling());
+                        }
+                        else
+                        {
+                            relinkPrevSibling(key, ptrChildDataNode->getNextSibling(), uidChildNode);
+                        }
+
 #ifdef __CONCURRENT__
                         if (*uidToDelete == uidChildNode)
                         {
@@ -649,6 +957,278 @@ public:
         return ErrorCode::Success;
     }
 
+    // Applies a batch of inserts. The entries are sorted and grouped by the leaf they fall into, so that each group costs
+    // one descent, and a leaf that overflows is split once for the whole group. A group keeps its whole path latched, from
+    // the root down, as the split may reach up to the root; the operations of other threads get in between the groups.
+    template <typename InputIterator>
+    ErrorCode insertBatch(InputIterator itBegin, InputIterator itEnd)
+    {
+        std::vector<std::pair<KeyType, ValueType>> vtEntries(itBegin, itEnd);
+
+        std::stable_sort(vtEntries.begin(), vtEntries.end(), [](const std::pair<KeyType, ValueType>& lhs, const std::pair<KeyType, ValueType>& rhs)
+            {
+                return lhs.first < rhs.first;
+            });
+
+#ifdef __BLINK_TREE__
+        // The B-link splits do not latch the path they restructure, see insertBLink.
+        for (auto it = vtEntries.begin(); it != vtEntries.end(); it++)
+        {
+            if (insertBLink((*it).first, (*it).second) != ErrorCode::Success)
+            {
+                return ErrorCode::InsertFailed;
+            }
+        }
+
+        return ErrorCode::Success;
+#endif __BLINK_TREE__
+
+        auto it = vtEntries.begin();
+        while (it != vtEntries.end())
+        {
+            std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtPath;
+            std::vector<std::unique_lock<VersionedSharedMutex>> vtLocks;
+
+            ObjectUIDType uidCurrentNode;
+            ObjectTypePtr ptrCurrentNode = nullptr;
+            std::optional<KeyType> keyLowerBound = std::nullopt, keyUpperBound = std::nullopt;
+
+            getLeafNode((*it).first, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtPath, vtLocks, true);
+
+            auto itGroupEnd = vtEntries.end();
+            if (keyUpperBound)
+            {
+                itGroupEnd = std::lower_bound(it, vtEntries.end(), *keyUpperBound, [](const std::pair<KeyType, ValueType>& entry, const KeyType& key)
+                    {
+                        return entry.first < key;
+                    });
+            }
+
+            std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+            ptrDataNode->insertBatch(it, itGroupEnd);
+
+#ifdef __TREE_AWARE_CACHE__
+            ptrCurrentNode->dirty = true;
+#endif __TREE_AWARE_CACHE__
+
+            if (ptrDataNode->requireSplit(m_nDegree))
+            {
+                m_nStructureVersion++;
+                splitPath(vtPath, vtLocks);
+            }
+
+            m_ptrCache->reorder(vtPath, false);
+
+            it = itGroupEnd;
+        }
+
+        return ErrorCode::Success;
+    }
+
+    // Counterpart of insertBatch; the keys that are not found are skipped, in which case KeyDoesNotExist is returned once
+    // all the others have been removed.
+    template <typename InputIterator>
+    ErrorCode removeBatch(InputIterator itBegin, InputIterator itEnd)
+    {
+        std::vector<KeyType> vtKeys(itBegin, itEnd);
+
+        std::sort(vtKeys.begin(), vtKeys.end());
+        vtKeys.erase(std::unique(vtKeys.begin(), vtKeys.end()), vtKeys.end());
+
+        ErrorCode errCode = ErrorCode::Success;
+
+#ifdef __BLINK_TREE__
+        for (auto it = vtKeys.begin(); it != vtKeys.end(); it++)
+        {
+            if (removeBLink(*it) != ErrorCode::Success)
+            {
+                errCode = ErrorCode::KeyDoesNotExist;
+            }
+        }
+
+        return errCode;
+#endif __BLINK_TREE__
+
+        auto it = vtKeys.begin();
+        while (it != vtKeys.end())
+        {
+            std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtPath;
+            std::vector<std::unique_lock<VersionedSharedMutex>> vtLocks;
+
+            ObjectUIDType uidCurrentNode;
+            ObjectTypePtr ptrCurrentNode = nullptr;
+            std::optional<KeyType> keyLowerBound = std::nullopt, keyUpperBound = std::nullopt;
+
+            getLeafNode(*it, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtPath, vtLocks, true);
+
+            auto itGroupEnd = keyUpperBound ? std::lower_bound(it, vtKeys.end(), *keyUpperBound) : vtKeys.end();
+
+            std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+            size_t nRemoved = ptrDataNode->removeBatch(it, itGroupEnd);
+
+            if (nRemoved != std::distance(it, itGroupEnd))
+            {
+                errCode = ErrorCode::KeyDoesNotExist;
+            }
+
+            if (nRemoved > 0)
+            {
+#ifdef __TREE_AWARE_CACHE__
+                ptrCurrentNode->dirty = true;
+#endif __TREE_AWARE_CACHE__
+
+                if (vtPath.size() > 1 && ptrDataNode->requireMerge(m_nDegree))
+                {
+                    m_nStructureVersion++;
+                    rebalancePath(vtPath, *it, vtLocks);
+                }
+            }
+
+            m_ptrCache->reorder(vtPath, false);
+
+            it = itGroupEnd;
+        }
+
+        return errCode;
+    }
+
+    // Visits the entries in [keyBegin, keyEnd) in key order; the scan stops early once fnCallback(key, value) returns false.
+    template <typename Callback>
+    ErrorCode scan(const KeyType& keyBegin, const KeyType& keyEnd, Callback fnCallback)
+    {
+        if (!(keyBegin < keyEnd))
+        {
+            return ErrorCode::Success;
+        }
+
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+        std::vector<std::shared_lock<VersionedSharedMutex>> vtLocks;
+
+        ObjectUIDType uidCurrentNode;
+        ObjectTypePtr ptrCurrentNode = nullptr;
+        std::optional<KeyType> keyLowerBound = std::nullopt, keyUpperBound = std::nullopt;
+
+        getLeafNode(keyBegin, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtAccessedNodes, vtLocks, false);
+
+        // Only the descent path is reordered; the leaves visited by the scan are not promoted.
+        m_ptrCache->reorder(vtAccessedNodes);
+        vtAccessedNodes.clear();
+
+        std::shared_lock<VersionedSharedMutex> lock_node;
+
+#ifdef __CONCURRENT__
+        lock_node = std::move(vtLocks.back());
+#endif __CONCURRENT__
+
+        do
+        {
+            std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+            if (!ptrDataNode->scan(keyBegin, keyEnd, fnCallback))
+            {
+                break;
+            }
+        } while (getNextLeafNode(uidCurrentNode, ptrCurrentNode, lock_node));
+
+        return ErrorCode::Success;
+    }
+
+    ErrorCode rangeQuery(const KeyType& keyBegin, const KeyType& keyEnd, std::vector<std::pair<KeyType, ValueType>>& vtResult)
+    {
+        return scan(keyBegin, keyEnd, [&vtResult](const KeyType& key, const ValueType& value)
+            {
+                vtResult.push_back(std::make_pair(key, value));
+                return true;
+            });
+    }
+
+    // A bidirectional position over the store. It pins the leaf it stands on and remembers its key, so that a step can
+    // continue within that leaf while the tree has not been restructured, and re-find its place from the root otherwise.
+    class Cursor
+    {
+        friend class BPlusStore;
+
+    private:
+        BPlusStore* m_ptrStore;
+
+        bool m_bValid;
+        KeyType m_key;
+        ValueType m_value;
+
+        ObjectUIDType m_uidLeaf;
+        ObjectTypePtr m_ptrLeaf;
+        size_t m_nVersion;
+
+    public:
+        Cursor(BPlusStore* ptrStore)
+            : m_ptrStore(ptrStore)
+            , m_bValid(false)
+            , m_ptrLeaf(nullptr)
+            , m_nVersion(0)
+        {
+        }
+
+        ~Cursor()
+        {
+            reset();
+        }
+
+        // Positions the cursor on the first entry whose key is not less than 'key'.
+        ErrorCode seek(const KeyType& key)
+        {
+            return lower_bound(key);
+        }
+
+        ErrorCode lower_bound(const KeyType& key)
+        {
+            return m_ptrStore->locateCursor(*this, key, true, true);
+        }
+
+        ErrorCode upper_bound(const KeyType& key)
+        {
+            return m_ptrStore->locateCursor(*this, key, true, false);
+        }
+
+        ErrorCode next()
+        {
+            return m_ptrStore->moveCursor(*this, true);
+        }
+
+        ErrorCode prev()
+        {
+            return m_ptrStore->moveCursor(*this, false);
+        }
+
+        inline bool valid() const
+        {
+            return m_bValid;
+        }
+
+        inline const KeyType& getKey() const
+        {
+            return m_key;
+        }
+
+        inline const ValueType& getValue() const
+        {
+            return m_value;
+        }
+
+        // Releases the pinned leaf.
+        void reset()
+        {
+            m_bValid = false;
+            m_ptrLeaf = nullptr;
+        }
+    };
+
+    Cursor getCursor()
+    {
+        return Cursor(this);
+    }
+
     void print(std::ofstream & out)
     {
         int nSpace = 7;
@@ -660,14 +1240,9 @@ public:
 
         out << std::endl;
 
+        ObjectUIDType uidRootNode;
         ObjectTypePtr ptrRootNode = nullptr;
-        std::optional<ObjectUIDType> uidUpdated = std::nullopt;
-        m_ptrCache->getObject(m_uidRootNode.value(), ptrRootNode, uidUpdated);
-
-        if (uidUpdated != std::nullopt)
-        {
-            m_uidRootNode = uidUpdated;
-        }
+        getRootNode(uidRootNode, ptrRootNode);
 
         if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrRootNode->data))
         {
@@ -688,110 +1263,1644 @@ public:
         return m_ptrCache->getCacheState(lru, map);
     }
 
-#ifdef __TREE_AWARE_CACHE__
-public:
-    void applyExistingUpdates(std::shared_ptr<ObjectType> ptrObject
-        , std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUIDUpdates)
+    // Bounds the cache by the memory that its nodes take up (see LRUCache::setCapacityBytes); 0 restores the node count.
+    void setCacheCapacityBytes(size_t nBytes)
     {
-        if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrObject->data))
-        {
-            std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrObject->data);
+        m_ptrCache->setCapacityBytes(nBytes);
+    }
 
-            auto it = ptrIndexNode->m_ptrData->m_vtChildren.begin();
-            while (it != ptrIndexNode->m_ptrData->m_vtChildren.end())
-            {
-                if (mpUIDUpdates.find(*it) != mpUIDUpdates.end())
-                {
-                    ObjectUIDType uidTemp = *it;
+    size_t getCacheBytes()
+    {
+        return m_ptrCache->getCacheBytes();
+    }
 
-                    *it = *(mpUIDUpdates[*it].first);
+#ifdef __TREE_AWARE_CACHE__
+    // The hits and misses of the cache per tree level, the root being level 0.
+    void getCacheLevelStats(std::vector<std::pair<size_t, size_t>>& vtStats)
+    {
+        return m_ptrCache->getLevelStats(vtStats);
+    }
+#endif __TREE_AWARE_CACHE__
 
-                    mpUIDUpdates.erase(uidTemp);
+private:
+    // Splits 'nCount' entries into as few nodes as the fill factor allows and spreads them evenly, so that no node ends up
+    // with less than 'nMinimum' entries.
+    std::vector<size_t> getBulkLoadPartitions(size_t nCount, size_t nCapacity, size_t nMinimum, float nFillFactor)
+    {
+        size_t nTarget = std::clamp<size_t>(std::floor(nCapacity * nFillFactor), nMinimum, nCapacity);
 
-                    ptrObject->dirty = true;
-                }
-                it++;
-            }
-        }
-        else //if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrObject->data))
+        size_t nNodes = std::ceil(nCount / (float)nTarget);
+        nNodes = std::max<size_t>(1, std::min(nNodes, nCount / nMinimum));
+
+        std::vector<size_t> vtPartitions(nNodes, nCount / nNodes);
+        for (size_t idx = 0; idx < nCount % nNodes; idx++)
         {
-            // Nothing to update in this case!
+            vtPartitions[idx]++;
         }
+
+        return vtPartitions;
     }
 
-    void applyExistingUpdates(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtNodes
-        , std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUIDUpdates)
+#ifdef __TREE_AWARE_CACHE__
+    // Builds the nodes off the cache and hands them over to the storage in one append, leaves first and the root last.
+    // Their uids (and thus the sibling links and child pointers) are computed up front from the serialized node sizes.
+    void bulkLoadToStorage(const std::vector<KeyType>& vtKeys, const std::vector<ValueType>& vtValues
+        , const std::vector<std::vector<size_t>>& vtLevels, std::optional<ObjectUIDType>& uidRootNode)
     {
-        auto it = vtNodes.begin();
-        while (it != vtNodes.end())
+        std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>> vtObjects;
+
+        std::vector<std::shared_ptr<DataNodeType>> vtLeaves;
+        std::vector<std::vector<std::shared_ptr<IndexNodeType>>> vtIndexLevels;
+
+        // The lowest key under each node of the level that has been built last.
+        std::vector<KeyType> vtLowestKeys;
+
+        size_t nOffset = 0;
+        for (auto it = vtLevels[0].begin(); it != vtLevels[0].end(); it++)
         {
-            if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*(*it).second.second->data))
-            {
-                std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*(*it).second.second->data);
+            vtLeaves.push_back(std::make_shared<DataNodeType>(
+                vtKeys.cbegin() + nOffset, vtKeys.cbegin() + nOffset + *it, vtValues.cbegin() + nOffset, vtValues.cbegin() + nOffset + *it));
 
-                auto it_children = ptrIndexNode->m_ptrData->m_vtChildren.begin();
-                while (it_children != ptrIndexNode->m_ptrData->m_vtChildren.end())
-                {
-                    if (mpUIDUpdates.find(*it_children) != mpUIDUpdates.end())
-                    {
-                        ObjectUIDType uidTemp = *it_children;
+            vtLowestKeys.push_back(vtKeys[nOffset]);
+            vtObjects.push_back(std::make_pair(ObjectUIDType(), std::make_pair(std::nullopt, std::make_shared<ObjectType>(vtLeaves.back()))));
 
-                        *it_children = *(mpUIDUpdates[*it_children].first);
+            nOffset += *it;
+        }
 
-                        mpUIDUpdates.erase(uidTemp);
+        for (size_t nLevel = 1; nLevel < vtLevels.size(); nLevel++)
+        {
+            std::vector<std::shared_ptr<IndexNodeType>> vtNodes;
+            std::vector<KeyType> vtNodesLowestKeys;
 
-                        (*it).second.second->dirty = true;
-                    }
-                    it_children++;
-                }
-            }
-            else //if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*(*it).second.second->data))
+            // The children are filled in once their uids are known.
+            std::vector<ObjectUIDType> vtChildren(m_nDegree + 1);
+
+            nOffset = 0;
+            for (auto it = vtLevels[nLevel].begin(); it != vtLevels[nLevel].end(); it++)
             {
-                // Nothing to update in this case!
+                vtNodes.push_back(std::make_shared<IndexNodeType>(
+                    vtLowestKeys.cbegin() + nOffset + 1, vtLowestKeys.cbegin() + nOffset + *it, vtChildren.cbegin(), vtChildren.cbegin() + *it));
+
+                vtNodesLowestKeys.push_back(vtLowestKeys[nOffset]);
+                vtObjects.push_back(std::make_pair(ObjectUIDType(), std::make_pair(std::nullopt, std::make_shared<ObjectType>(vtNodes.back()))));
+
+                nOffset += *it;
             }
-            it++;
-        }
-    }
 
-    void prepareFlush(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtNodes
-        , size_t& nPos, size_t nBlockSize, ObjectUIDType::Media nMediaType)
-    {
-        std::vector<bool> vtAppliedUpdates;
-        vtAppliedUpdates.resize(vtNodes.size(), false);
+            vtIndexLevels.push_back(std::move(vtNodes));
+            vtLowestKeys = std::move(vtNodesLowestKeys);
+        }
 
-        for (int idx = 0; idx < vtNodes.size(); idx++)
-        {
-            if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*vtNodes[idx].second.second->data))
+        m_ptrCache->appendObjects(vtObjects, [&](std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtBatch
+            , size_t& nPos, size_t nBlockSize, ObjectUIDType::Media nMediaType)
             {
-                std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*vtNodes[idx].second.second->data);
+                std::vector<ObjectUIDType> vtUIDs;
 
-                auto it = ptrIndexNode->m_ptrData->m_vtChildren.begin();
-                while (it != ptrIndexNode->m_ptrData->m_vtChildren.end())
-                {
-                    for (int jdx = 0; jdx < idx; jdx++)
+                auto fnPlace = [&](size_t nNodeSize)
                     {
-                        if (vtAppliedUpdates[jdx])
-                            continue;
+                        ObjectUIDType uidNode = ObjectUIDType::createAddressFromArgs(nMediaType, nPos, nBlockSize, nNodeSize);
 
-                        if (*it == vtNodes[jdx].first)
-                        {
-                            *it = *vtNodes[jdx].second.first;
-                            vtNodes[idx].second.second->dirty = true;
+                        vtBatch[vtUIDs.size()].first = uidNode;
+                        vtBatch[vtUIDs.size()].second.first = uidNode;
+                        vtUIDs.push_back(uidNode);
 
-                            vtAppliedUpdates[jdx] = true;
-                            break;
-                        }
-                    }
-                    it++;
+                        nPos += std::ceil(nNodeSize / (float)nBlockSize);
+                    };
+
+                for (size_t idx = 0; idx < vtLeaves.size(); idx++)
+                {
+                    fnPlace(vtLeaves[idx]->getSize());
                 }
 
-                if (!vtNodes[idx].second.second->dirty)
+                for (size_t idx = 0; idx < vtLeaves.size(); idx++)
                 {
-                    vtNodes.erase(vtNodes.begin() + idx); idx--;
-                    continue;
+                    vtLeaves[idx]->setPrevSibling(idx > 0 ? std::optional<ObjectUIDType>(vtUIDs[idx - 1]) : std::nullopt);
+                    vtLeaves[idx]->setNextSibling(idx + 1 < vtLeaves.size() ? std::optional<ObjectUIDType>(vtUIDs[idx + 1]) : std::nullopt);
                 }
 
-                size_t nNodeSize = ptrIndexNode->getSize();
+                size_t nChildIdx = 0;
+                for (auto it_level = vtIndexLevels.begin(); it_level != vtIndexLevels.end(); it_level++)
+                {
+                    for (auto it = (*it_level).begin(); it != (*it_level).end(); it++)
+                    {
+                        auto& vtChildren = (*it)->m_ptrData->m_vtChildren;
+                        std::copy(vtUIDs.begin() + nChildIdx, vtUIDs.begin() + nChildIdx + vtChildren.size(), vtChildren.begin());
+
+                        nChildIdx += vtChildren.size();
+
+                        fnPlace((*it)->getSize());
+                    }
+                }
+            });
+
+        uidRootNode = vtObjects.back().first;
+    }
+#else __TREE_AWARE_CACHE__
+    // Every object is resident in this mode, hence the nodes are created in the cache right away, leaves first.
+    void bulkLoadToCache(const std::vector<KeyType>& vtKeys, const std::vector<ValueType>& vtValues
+        , const std::vector<std::vector<size_t>>& vtLevels, std::optional<ObjectUIDType>& uidRootNode)
+    {
+        std::vector<ObjectUIDType> vtUIDs;
+        std::vector<KeyType> vtLowestKeys;
+
+        size_t nOffset = 0;
+        for (auto it = vtLevels[0].begin(); it != vtLevels[0].end(); it++)
+        {
+            std::optional<ObjectUIDType> uidLeaf = std::nullopt;
+            std::optional<ObjectUIDType> uidPrevSibling = vtUIDs.size() > 0 ? std::optional<ObjectUIDType>(vtUIDs.back()) : std::nullopt;
+
+            m_ptrCache->template createObjectOfType<DataNodeType>(uidLeaf,
+                vtKeys.cbegin() + nOffset, vtKeys.cbegin() + nOffset + *it,
+                vtValues.cbegin() + nOffset, vtValues.cbegin() + nOffset + *it,
+                uidPrevSibling, std::optional<ObjectUIDType>());
+
+            if (uidPrevSibling)
+            {
+                std::shared_ptr<DataNodeType> ptrPrevSibling = nullptr;
+                m_ptrCache->template getObjectOfType<std::shared_ptr<DataNodeType>>(*uidPrevSibling, ptrPrevSibling);
+
+                ptrPrevSibling->setNextSibling(uidLeaf);
+
+#ifdef __BLINK_TREE__
+                ptrPrevSibling->setHighKey(vtKeys[nOffset]);
+#endif __BLINK_TREE__
+            }
+
+            vtUIDs.push_back(*uidLeaf);
+            vtLowestKeys.push_back(vtKeys[nOffset]);
+
+            nOffset += *it;
+        }
+
+        for (size_t nLevel = 1; nLevel < vtLevels.size(); nLevel++)
+        {
+            std::vector<ObjectUIDType> vtNodesUIDs;
+            std::vector<KeyType> vtNodesLowestKeys;
+
+            nOffset = 0;
+            for (auto it = vtLevels[nLevel].begin(); it != vtLevels[nLevel].end(); it++)
+            {
+                std::optional<ObjectUIDType> uidNode = std::nullopt;
+
+                m_ptrCache->template createObjectOfType<IndexNodeType>(uidNode,
+                    vtLowestKeys.cbegin() + nOffset + 1, vtLowestKeys.cbegin() + nOffset + *it,
+                    vtUIDs.cbegin() + nOffset, vtUIDs.cbegin() + nOffset + *it);
+
+#ifdef __BLINK_TREE__
+                if (vtNodesUIDs.size() > 0)
+                {
+                    std::shared_ptr<IndexNodeType> ptrPrevSibling = nullptr;
+                    m_ptrCache->template getObjectOfType<std::shared_ptr<IndexNodeType>>(vtNodesUIDs.back(), ptrPrevSibling);
+
+                    ptrPrevSibling->setRightSibling(uidNode);
+                    ptrPrevSibling->setHighKey(vtLowestKeys[nOffset]);
+                }
+#endif __BLINK_TREE__
+
+                vtNodesUIDs.push_back(*uidNode);
+                vtNodesLowestKeys.push_back(vtLowestKeys[nOffset]);
+
+                nOffset += *it;
+            }
+
+            vtUIDs = std::move(vtNodesUIDs);
+            vtLowestKeys = std::move(vtNodesLowestKeys);
+        }
+
+        uidRootNode = vtUIDs.back();
+    }
+#endif __TREE_AWARE_CACHE__
+
+    // Splits the overflowing nodes along 'vtPath' (root first) bottom-up. An overflowing node hands chunks off its upper end
+    // to new right siblings until it fits; the chunks are sized evenly so that none of the siblings overflows in turn.
+    // On return the new siblings follow the node they were split from in 'vtPath', so that reordering it keeps every node
+    // ahead of its children in the cache. A new root is latched into 'vtLocks' before it is published.
+    void splitPath(std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vtPath, std::vector<std::unique_lock<VersionedSharedMutex>>& vtLocks)
+    {
+        std::vector<std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>> vtSiblings(vtPath.size());
+
+        for (int nLevel = vtPath.size() - 1; nLevel >= 0; nLevel--)
+        {
+            ObjectUIDType uidCurrentNode = vtPath[nLevel].first;
+            ObjectTypePtr ptrCurrentNode = vtPath[nLevel].second;
+
+            do
+            {
+                KeyType pivotKey;
+                std::optional<ObjectUIDType> uidRHSNode = std::nullopt;
+
+                if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data))
+                {
+                    std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data);
+
+                    if (!ptrIndexNode->requireSplit(m_nDegree))
+                    {
+                        break;
+                    }
+
+                    size_t nChildren = ptrIndexNode->getKeysCount() + 1;
+                    size_t nParts = std::ceil(nChildren / (float)(m_nDegree + 1));
+
+                    if (ptrIndexNode->template split<std::shared_ptr<CacheType>>(m_ptrCache, uidRHSNode, pivotKey, nChildren - 1 - nChildren / nParts) != ErrorCode::Success)
+                    {
+                        throw new std::exception("should not occur!");
+                    }
+                }
+                else
+                {
+                    std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+                    if (!ptrDataNode->requireSplit(m_nDegree))
+                    {
+                        break;
+                    }
+
+                    size_t nKeys = ptrDataNode->getKeysCount();
+                    size_t nParts = std::ceil(nKeys / (float)m_nDegree);
+
+                    std::optional<ObjectUIDType> uidNextSibling = ptrDataNode->getNextSibling();
+
+                    if (ptrDataNode->template split<std::shared_ptr<CacheType>, ObjectUIDType>(m_ptrCache, uidCurrentNode, uidRHSNode, pivotKey, nKeys - (nKeys + nParts - 1) / nParts) != ErrorCode::Success)
+                    {
+                        throw new std::exception("should not occur!");
+                    }
+
+#ifdef __TREE_AWARE_CACHE__
+                    // The address of a released leaf may have been reused for the new one.
+                    discardSiblingUIDUpdate(*uidRHSNode);
+#endif __TREE_AWARE_CACHE__
+
+                    relinkPrevSibling(pivotKey, uidNextSibling, *uidRHSNode);
+                }
+
+#ifdef __TREE_AWARE_CACHE__
+                ptrCurrentNode->dirty = true;
+#endif __TREE_AWARE_CACHE__
+
+                if (nLevel == 0)
+                {
+                    // The root has been split, hence the tree grows by a level. The new root may take further splits from
+                    // this loop, so it is latched before anyone else can reach it.
+                    std::optional<ObjectUIDType> uidRootNode = std::nullopt;
+                    m_ptrCache->template createObjectOfType<IndexNodeType>(uidRootNode, pivotKey, uidCurrentNode, *uidRHSNode);
+
+                    ObjectTypePtr ptrRootNode = nullptr;
+
+#ifdef __TREE_AWARE_CACHE__
+                    std::optional<ObjectUIDType> uidUpdated = std::nullopt;
+                    m_ptrCache->getObject(*uidRootNode, ptrRootNode, uidUpdated);
+
+                    if (uidUpdated != std::nullopt)
+                    {
+                        uidRootNode = uidUpdated;
+                    }
+#else __TREE_AWARE_CACHE__
+                    m_ptrCache->getObject(*uidRootNode, ptrRootNode);
+#endif __TREE_AWARE_CACHE__
+
+#ifdef __CONCURRENT__
+                    vtLocks.push_back(std::unique_lock<VersionedSharedMutex>(ptrRootNode->mutex));
+#endif __CONCURRENT__
+
+                    m_uidRootNode.store(*uidRootNode);
+
+                    vtPath.insert(vtPath.begin(), std::make_pair(*uidRootNode, ptrRootNode));
+                    vtSiblings.insert(vtSiblings.begin(), std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>());
+                    nLevel++;
+
+                    vtSiblings[nLevel].push_back(std::make_pair(*uidRHSNode, nullptr));
+                    continue;
+                }
+
+                vtSiblings[nLevel].push_back(std::make_pair(*uidRHSNode, nullptr));
+
+                std::shared_ptr<IndexNodeType> ptrParentNode = std::get<std::shared_ptr<IndexNodeType>>(*vtPath[nLevel - 1].second->data);
+
+                if (ptrParentNode->insert(pivotKey, *uidRHSNode) != ErrorCode::Success)
+                {
+                    throw new std::exception("should not occur!");
+                }
+
+#ifdef __TREE_AWARE_CACHE__
+                vtPath[nLevel - 1].second->dirty = true;
+#endif __TREE_AWARE_CACHE__
+            } while (true);
+        }
+
+        for (size_t nLevel = vtPath.size(); nLevel-- > 0;)
+        {
+            vtPath.insert(vtPath.begin() + nLevel + 1, vtSiblings[nLevel].begin(), vtSiblings[nLevel].end());
+        }
+    }
+
+    // Rebalances the underflowing nodes along 'vtPath' (root first) bottom-up, with one merge or redistribution per level as
+    // in remove. 'key' is one of the keys removed from the leaf and locates the path's nodes in their parents. The locks
+    // in 'vtLocks' are released for the nodes that get deleted.
+    void rebalancePath(std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vtPath, const KeyType& key, std::vector<std::unique_lock<VersionedSharedMutex>>& vtLocks)
+    {
+        auto fnReleaseLock = [&vtLocks](ObjectTypePtr ptrNode)
+            {
+                auto it = vtLocks.begin();
+                while (it != vtLocks.end())
+                {
+                    if ((*it).mutex() == &ptrNode->mutex)
+                    {
+                        vtLocks.erase(it);
+                        break;
+                    }
+                    it++;
+                }
+            };
+
+        for (size_t nLevel = vtPath.size() - 1; nLevel > 0; nLevel--)
+        {
+            ObjectUIDType uidChildNode = vtPath[nLevel].first;
+            ObjectTypePtr ptrChildNode = vtPath[nLevel].second;
+
+            std::shared_ptr<IndexNodeType> ptrParentIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*vtPath[nLevel - 1].second->data);
+
+            std::optional<ObjectUIDType> uidToDelete = std::nullopt;
+
+            if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrChildNode->data))
+            {
+                std::shared_ptr<IndexNodeType> ptrChildIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrChildNode->data);
+
+                if (!ptrChildIndexNode->requireMerge(m_nDegree))
+                {
+                    break;
+                }
+
+                ptrParentIndexNode->template rebalanceIndexNode<std::shared_ptr<CacheType>, shared_ptr<IndexNodeType>>(m_ptrCache, uidChildNode, ptrChildIndexNode, key, m_nDegree, uidToDelete);
+            }
+            else
+            {
+                std::shared_ptr<DataNodeType> ptrChildDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrChildNode->data);
+
+                if (!ptrChildDataNode->requireMerge(m_nDegree))
+                {
+                    break;
+                }
+
+                ptrParentIndexNode->template rebalanceDataNode<std::shared_ptr<CacheType>, shared_ptr<DataNodeType>>(m_ptrCache, uidChildNode, ptrChildDataNode, key, m_nDegree, uidToDelete);
+
+                if (uidToDelete)
+                {
+                    if (*uidToDelete == uidChildNode)
+                    {
+                        relinkPrevSibling(key, ptrChildDataNode->getNextSibling(), *ptrChildDataNode->getPrevSibling());
+                    }
+                    else
+                    {
+                        relinkPrevSibling(key, ptrChildDataNode->getNextSibling(), uidChildNode);
+                    }
+                }
+            }
+
+#ifdef __TREE_AWARE_CACHE__
+            vtPath[nLevel - 1].second->dirty = true;
+            ptrChildNode->dirty = true;
+#endif __TREE_AWARE_CACHE__
+
+            if (uidToDelete)
+            {
+                if (*uidToDelete == uidChildNode)
+                {
+                    fnReleaseLock(ptrChildNode);
+                }
+
+                m_ptrCache->remove(*uidToDelete);
+            }
+        }
+
+        std::pair<ObjectUIDType, ObjectTypePtr>& prRootNode = vtPath[0];
+
+        if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*prRootNode.second->data))
+        {
+            std::shared_ptr<IndexNodeType> ptrRootIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*prRootNode.second->data);
+
+            if (ptrRootIndexNode->getKeysCount() == 0)
+            {
+                m_uidRootNode.store(ptrRootIndexNode->getChildAt(0));
+
+                fnReleaseLock(prRootNode.second);
+                m_ptrCache->remove(prRootNode.first);
+            }
+        }
+    }
+
+#ifdef __CONCURRENT__
+    // Lock-free search through optimistic lock coupling: instead of locking a node, the reader samples its version, reads
+    // it, and then checks that the version is unchanged; the parent is validated once more after the child's version has
+    // been sampled, so that the child is known to have still been linked at that point. The root handle's version stands
+    // in for the root's parent. A merge or redistribution alters the sibling under the parent's lock only, hence the whole path is
+    // validated once the leaf has been read. Returns false if a writer got in the way, or, with 'bResident' cleared, if a
+    // node on the path is not in the cache; fetching it may require updating its parent, which is left to the locking path.
+    bool searchOptimistic(const KeyType& key, ValueType& value, ErrorCode& errCode, bool& bResident)
+    {
+        bool bValid = false;
+
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+        std::vector<uint64_t> vtVersions;
+
+        size_t nSlot = m_ptrCache->enterEpoch();
+
+        uint64_t nParentVersion;
+        const VersionedSharedMutex* ptrParentMutex = nullptr;
+
+        ObjectUIDType uidCurrentNode;
+
+#ifdef __TREE_AWARE_CACHE__
+        uint8_t nLevel = 0;
+#endif __TREE_AWARE_CACHE__
+
+        auto fnValidateParent = [&]()
+            {
+                return ptrParentMutex == nullptr ? m_uidRootNode.validate(nParentVersion) : ptrParentMutex->validate(nParentVersion);
+            };
+
+        if (m_uidRootNode.tryLoad(uidCurrentNode, nParentVersion))
+        {
+            while (fnValidateParent())
+            {
+                ObjectTypePtr ptrCurrentNode = nullptr;
+
+#ifdef __TREE_AWARE_CACHE__
+                if constexpr (CacheType::SWIZZLED_CHILDREN)
+                {
+                    if (vtAccessedNodes.size() > 0)
+                    {
+                        ptrCurrentNode = std::static_pointer_cast<ObjectType>(
+                            std::get<std::shared_ptr<IndexNodeType>>(*vtAccessedNodes.back().second->data)->getSwizzledChild(uidCurrentNode));
+
+                        if (ptrCurrentNode != nullptr && !m_ptrCache->validateSwizzled(ptrCurrentNode))
+                        {
+                            ptrCurrentNode = nullptr;
+                        }
+                    }
+                }
+#endif __TREE_AWARE_CACHE__
+
+                if (ptrCurrentNode == nullptr && m_ptrCache->peekObject(uidCurrentNode, ptrCurrentNode) != CacheErrorCode::Success)
+                {
+                    bResident = !fnValidateParent();
+                    break;
+                }
+
+                uint64_t nVersion;
+                if (!ptrCurrentNode->mutex.tryReadOptimistic(nVersion) || !fnValidateParent())
+                {
+                    break;
+                }
+
+                vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
+                vtVersions.push_back(nVersion);
+
+#ifdef __TREE_AWARE_CACHE__
+                ptrCurrentNode->level = nLevel;
+#endif __TREE_AWARE_CACHE__
+
+#ifdef __BLINK_TREE__
+                // A node split after its parent was read keeps the upper part of its range behind its right link.
+                std::optional<ObjectUIDType> uidRightSibling = getRightLink(ptrCurrentNode, key);
+                if (uidRightSibling)
+                {
+                    uidCurrentNode = *uidRightSibling;
+                    ptrParentMutex = &ptrCurrentNode->mutex;
+                    nParentVersion = nVersion;
+                    continue;
+                }
+#endif __BLINK_TREE__
+
+                if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data))
+                {
+                    uidCurrentNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data)->getChild(key);
+
+#ifdef __TREE_AWARE_CACHE__
+                    nLevel++;
+#endif __TREE_AWARE_CACHE__
+                }
+                else
+                {
+                    ValueType _value;
+                    ErrorCode _errCode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data)->getValue(key, _value);
+
+                    bool bConsistent = true;
+                    for (size_t nIdx = vtAccessedNodes.size(); bConsistent && nIdx-- > 0;)
+                    {
+                        bConsistent = vtAccessedNodes[nIdx].second->mutex.validate(vtVersions[nIdx]);
+                    }
+
+                    if (bConsistent)
+                    {
+                        if (_errCode == ErrorCode::Success)
+                        {
+                            value = _value;
+                        }
+
+                        errCode = _errCode;
+                        bValid = true;
+                    }
+
+                    break;
+                }
+
+                ptrParentMutex = &ptrCurrentNode->mutex;
+                nParentVersion = nVersion;
+            }
+        }
+
+        m_ptrCache->leaveEpoch(nSlot);
+
+        if (bValid)
+        {
+            // The nodes may have been flushed meanwhile.
+            m_ptrCache->reorder(vtAccessedNodes, false);
+        }
+
+        return bValid;
+    }
+#endif __CONCURRENT__
+
+    // Fetches the root; with the tree-aware cache a relocated root is published under its new uid.
+    void getRootNode(ObjectUIDType& uidRootNode, ObjectTypePtr& ptrRootNode)
+    {
+        uidRootNode = m_uidRootNode.load();
+        ptrRootNode = nullptr;
+
+#ifdef __TREE_AWARE_CACHE__
+        std::optional<ObjectUIDType> uidUpdated = std::nullopt;
+        m_ptrCache->getObject(uidRootNode, ptrRootNode, uidUpdated);
+
+        if (uidUpdated != std::nullopt)
+        {
+            m_uidRootNode.compareExchange(uidRootNode, *uidUpdated);
+            uidRootNode = *uidUpdated;
+        }
+#else __TREE_AWARE_CACHE__
+        m_ptrCache->getObject(uidRootNode, ptrRootNode);
+#endif __TREE_AWARE_CACHE__
+
+        if (ptrRootNode == nullptr)
+        {
+            throw new std::exception("should not occur!");
+        }
+
+#ifdef __TREE_AWARE_CACHE__
+        ptrRootNode->level = 0;
+#endif __TREE_AWARE_CACHE__
+    }
+
+#ifdef __CONCURRENT__
+    // Latches the root and pushes its lock onto 'vtLocks'. Outside of the B-link mode the root is replaced only under its
+    // own exclusive latch, hence a node that is still the root once latched stays so until it is released; otherwise it
+    // has been replaced while this thread was waiting, and the new root is tried instead. The epoch keeps a replaced root
+    // from being deleted under the waiting thread.
+    template <typename LockType>
+    void lockRootNode(ObjectUIDType& uidRootNode, ObjectTypePtr& ptrRootNode, std::vector<LockType>& vtLocks)
+    {
+        do
+        {
+            size_t nSlot = m_ptrCache->enterEpoch();
+
+            getRootNode(uidRootNode, ptrRootNode);
+
+            LockType lock(ptrRootNode->mutex);
+
+            bool bRoot = (m_uidRootNode.load() == uidRootNode);
+            if (bRoot)
+            {
+                vtLocks.push_back(std::move(lock));
+            }
+            else
+            {
+                lock.unlock();
+            }
+
+            m_ptrCache->leaveEpoch(nSlot);
+
+            if (bRoot)
+            {
+                return;
+            }
+        } while (true);
+    }
+#endif __CONCURRENT__
+
+    // Fetches the child 'uidChildNode' of the index node 'ptrParentNode'; with the tree-aware cache the parent is pointed to
+    // the child's new uid if the child has been relocated. A resident child is reached through the parent's swizzled
+    // reference to it when the cache supports them, without a lookup in the cache's directory; it is swizzled otherwise.
+    void getChildNode(const ObjectTypePtr& ptrParentNode, ObjectUIDType& uidChildNode, ObjectTypePtr& ptrChildNode)
+    {
+        ptrChildNode = nullptr;
+
+#ifdef __TREE_AWARE_CACHE__
+        std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrParentNode->data);
+
+        if constexpr (CacheType::SWIZZLED_CHILDREN)
+        {
+            ptrChildNode = std::static_pointer_cast<ObjectType>(ptrIndexNode->getSwizzledChild(uidChildNode));
+            if (ptrChildNode != nullptr && !m_ptrCache->validateSwizzled(ptrChildNode))
+            {
+                ptrChildNode = nullptr;
+            }
+        }
+
+        if (ptrChildNode == nullptr)
+        {
+            std::optional<ObjectUIDType> uidUpdated = std::nullopt;
+            m_ptrCache->getObject(uidChildNode, ptrChildNode, uidUpdated);
+
+            if (uidUpdated != std::nullopt)
+            {
+                ptrIndexNode->updateChildUID(uidChildNode, *uidUpdated);
+                ptrParentNode->dirty = true;
+
+                uidChildNode = *uidUpdated;
+            }
+
+            if constexpr (CacheType::SWIZZLED_CHILDREN)
+            {
+                if (ptrChildNode != nullptr)
+                {
+                    ptrIndexNode->swizzleChild(uidChildNode, ptrChildNode);
+                }
+            }
+        }
+#else __TREE_AWARE_CACHE__
+        m_ptrCache->getObject(uidChildNode, ptrChildNode);
+#endif __TREE_AWARE_CACHE__
+
+        if (ptrChildNode == nullptr)
+        {
+            throw new std::exception("should not occur!");
+        }
+
+#ifdef __TREE_AWARE_CACHE__
+        // Tags the child with its depth for the cache, which counts its hits by level and pins the upper ones.
+        if (ptrParentNode->level < ObjectType::UNKNOWN_LEVEL - 1)
+        {
+            ptrChildNode->level = ptrParentNode->level + 1;
+        }
+#endif __TREE_AWARE_CACHE__
+    }
+
+#ifdef __BLINK_TREE__
+    // Lehman-Yao B-link mode. Every node carries a high key and a link to its right sibling, so a split is complete for
+    // readers as soon as the node being split is released, and its parent is updated afterwards under the parent's lock
+    // alone. A descent that reaches a node whose high key is not greater than its key has raced such a split, and moves
+    // right instead. The point operations thus hold a single node lock at a time, besides the one they hand over when
+    // moving right, and the batch operations are carried out as a series of them.
+    ErrorCode insertBLink(const KeyType& key, const ValueType& value)
+    {
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtPath;
+
+        ObjectUIDType uidCurrentNode;
+        ObjectTypePtr ptrCurrentNode = nullptr;
+        std::unique_lock<VersionedSharedMutex> lock_node;
+
+        getLeafNodeBLink(key, uidCurrentNode, ptrCurrentNode, lock_node, vtPath);
+
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes(vtPath);
+        vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
+
+        std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+        if (ptrDataNode->insert(key, value) != ErrorCode::Success)
+        {
+            return ErrorCode::InsertFailed;
+        }
+
+        if (!ptrDataNode->requireSplit(m_nDegree))
+        {
+#ifdef __CONCURRENT__
+            lock_node.unlock();
+#endif __CONCURRENT__
+
+            m_ptrCache->reorder(vtAccessedNodes, false);
+            return ErrorCode::Success;
+        }
+
+        m_nStructureVersion++;
+
+        KeyType pivotKey;
+        std::optional<ObjectUIDType> uidRHSNode = std::nullopt;
+        std::optional<ObjectUIDType> uidNextSibling = ptrDataNode->getNextSibling();
+
+        if (ptrDataNode->template split<std::shared_ptr<CacheType>, ObjectUIDType>(m_ptrCache, uidCurrentNode, uidRHSNode, pivotKey) != ErrorCode::Success)
+        {
+            throw new std::exception("should not occur!");
+        }
+
+        relinkPrevSibling(pivotKey, uidNextSibling, *uidRHSNode);
+
+        // The height of the node that has just been split, counted from the leaves.
+        size_t nHeight = 0;
+
+        do
+        {
+#ifdef __CONCURRENT__
+            lock_node.unlock();
+#endif __CONCURRENT__
+
+            while (vtPath.size() == 0)
+            {
+                if (m_uidRootNode.load() == uidCurrentNode)
+                {
+                    std::optional<ObjectUIDType> uidRootNode = std::nullopt;
+                    m_ptrCache->template createObjectOfType<IndexNodeType>(uidRootNode, pivotKey, uidCurrentNode, *uidRHSNode);
+
+                    if (m_uidRootNode.compareExchange(uidCurrentNode, *uidRootNode))
+                    {
+                        m_ptrCache->reorder(vtAccessedNodes, false);
+                        return ErrorCode::Success;
+                    }
+
+                    // Another writer has grown the tree first; the new root has never been reachable.
+                    m_ptrCache->remove(*uidRootNode);
+                }
+
+                // The node was the root when it was reached, but another writer has split it as well and grows, or is about
+                // to grow, the tree by a level; its parent is therefore looked up afresh once the new root is in place.
+                ObjectUIDType uidLeafNode;
+                ObjectTypePtr ptrLeafNode = nullptr;
+                std::shared_lock<VersionedSharedMutex> lock_leaf;
+
+                getLeafNodeBLink(pivotKey, uidLeafNode, ptrLeafNode, lock_leaf, vtPath);
+
+                vtPath.resize(vtPath.size() > nHeight ? vtPath.size() - nHeight : 0);
+
+                if (vtPath.size() == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            uidCurrentNode = vtPath.back().first;
+            ptrCurrentNode = vtPath.back().second;
+            vtPath.pop_back();
+
+#ifdef __CONCURRENT__
+            lock_node = std::unique_lock<VersionedSharedMutex>(ptrCurrentNode->mutex);
+#endif __CONCURRENT__
+
+            // The parent on the path may have been split meanwhile too.
+            moveRight(pivotKey, uidCurrentNode, ptrCurrentNode, lock_node);
+
+            std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data);
+
+            if (ptrIndexNode->insert(pivotKey, *uidRHSNode) != ErrorCode::Success)
+            {
+                throw new std::exception("should not occur!");
+            }
+
+            if (!ptrIndexNode->requireSplit(m_nDegree))
+            {
+                break;
+            }
+
+            uidRHSNode = std::nullopt;
+
+            if (ptrIndexNode->template split<std::shared_ptr<CacheType>>(m_ptrCache, uidRHSNode, pivotKey) != ErrorCode::Success)
+            {
+                throw new std::exception("should not occur!");
+            }
+
+            nHeight++;
+        } while (true);
+
+#ifdef __CONCURRENT__
+        lock_node.unlock();
+#endif __CONCURRENT__
+
+        m_ptrCache->reorder(vtAccessedNodes, false);
+
+        return ErrorCode::Success;
+    }
+
+    ErrorCode searchBLink(const KeyType& key, ValueType& value)
+    {
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+
+        ObjectUIDType uidCurrentNode;
+        ObjectTypePtr ptrCurrentNode = nullptr;
+        std::shared_lock<VersionedSharedMutex> lock_node;
+
+        getLeafNodeBLink(key, uidCurrentNode, ptrCurrentNode, lock_node, vtAccessedNodes);
+
+        ErrorCode errCode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data)->getValue(key, value);
+
+        vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
+        m_ptrCache->reorder(vtAccessedNodes);
+
+        return errCode;
+    }
+
+    // Lehman and Yao leave deletion out, and a merge would release a node that a descent may still be about to reach
+    // through a stale pointer; the leaves are therefore not rebalanced in this mode, and an underfull one stays in place.
+    ErrorCode removeBLink(const KeyType& key)
+    {
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+
+        ObjectUIDType uidCurrentNode;
+        ObjectTypePtr ptrCurrentNode = nullptr;
+        std::unique_lock<VersionedSharedMutex> lock_node;
+
+        getLeafNodeBLink(key, uidCurrentNode, ptrCurrentNode, lock_node, vtAccessedNodes);
+
+        ErrorCode errCode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data)->remove(key);
+
+        vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
+        m_ptrCache->reorder(vtAccessedNodes, false);
+
+        return errCode;
+    }
+
+    // Descends to the leaf that covers 'key' and returns it locked through 'lock_leaf'. The index nodes are locked shared
+    // one at a time and appended to 'vtPath' (root first), as the parents to update should the leaf be split.
+    template <typename LockType>
+    void getLeafNodeBLink(const KeyType& key, ObjectUIDType& uidCurrentNode, ObjectTypePtr& ptrCurrentNode, LockType& lock_leaf
+        , std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vtPath)
+    {
+        uidCurrentNode = m_uidRootNode.load();
+
+        do
+        {
+            ptrCurrentNode = nullptr;
+            m_ptrCache->getObject(uidCurrentNode, ptrCurrentNode);
+
+            if (ptrCurrentNode == nullptr)
+            {
+                throw new std::exception("should not occur!");
+            }
+
+            // A node keeps its type, and none is released while point operations run, hence it can be told apart unlocked.
+            if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data))
+            {
+#ifdef __CONCURRENT__
+                lock_leaf = LockType(ptrCurrentNode->mutex);
+#endif __CONCURRENT__
+
+                moveRight(key, uidCurrentNode, ptrCurrentNode, lock_leaf);
+                return;
+            }
+
+            std::shared_lock<VersionedSharedMutex> lock_node;
+
+#ifdef __CONCURRENT__
+            lock_node = std::shared_lock<VersionedSharedMutex>(ptrCurrentNode->mutex);
+#endif __CONCURRENT__
+
+            moveRight(key, uidCurrentNode, ptrCurrentNode, lock_node);
+
+            vtPath.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
+
+            uidCurrentNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data)->getChild(key);
+        } while (true);
+    }
+
+    // Follows the right links for as long as 'key' lies beyond the high key of the locked node. The lock is handed over
+    // from left to right, the order in which scans hop between leaves as well.
+    template <typename LockType>
+    void moveRight(const KeyType& key, ObjectUIDType& uidCurrentNode, ObjectTypePtr& ptrCurrentNode, LockType& lock_node)
+    {
+        std::optional<ObjectUIDType> uidRightSibling = getRightLink(ptrCurrentNode, key);
+
+        while (uidRightSibling)
+        {
+            ObjectTypePtr ptrRightSibling = nullptr;
+            m_ptrCache->getObject(*uidRightSibling, ptrRightSibling);
+
+            if (ptrRightSibling == nullptr)
+            {
+                throw new std::exception("should not occur!");
+            }
+
+#ifdef __CONCURRENT__
+            LockType lock_sibling(ptrRightSibling->mutex);
+            lock_node.swap(lock_sibling);
+#endif __CONCURRENT__
+
+            uidCurrentNode = *uidRightSibling;
+            ptrCurrentNode = ptrRightSibling;
+
+            uidRightSibling = getRightLink(ptrCurrentNode, key);
+        }
+    }
+
+    // The right link to follow if 'key' (with 'bStrictlyBelow', the greatest key less than 'key') lies beyond the node.
+    std::optional<ObjectUIDType> getRightLink(const ObjectTypePtr& ptrNode, const KeyType& key, bool bStrictlyBelow = false)
+    {
+        std::optional<KeyType> keyHigh = getHighKey(ptrNode);
+
+        if (!keyHigh || (bStrictlyBelow ? !(*keyHigh < key) : key < *keyHigh))
+        {
+            return std::nullopt;
+        }
+
+        if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrNode->data))
+        {
+            return std::get<std::shared_ptr<IndexNodeType>>(*ptrNode->data)->getRightSibling();
+        }
+
+        return std::get<std::shared_ptr<DataNodeType>>(*ptrNode->data)->getNextSibling();
+    }
+
+    std::optional<KeyType> getHighKey(const ObjectTypePtr& ptrNode)
+    {
+        if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrNode->data))
+        {
+            return std::get<std::shared_ptr<IndexNodeType>>(*ptrNode->data)->getHighKey();
+        }
+
+        return std::get<std::shared_ptr<DataNodeType>>(*ptrNode->data)->getHighKey();
+    }
+#endif __BLINK_TREE__
+
+    // Descends to the leaf that covers 'key' (or, with 'bStrictlyBelow', the one holding the greatest key less than 'key').
+    // 'keyLowerBound' and 'keyUpperBound' receive the fences of the leaf, i.e. the lowest key of the leaf's range and the
+    // lowest key that belongs to the next leaf. The locks are coupled from the root down and the leaf's ends up at the
+    // back of 'vtLocks'; with 'bKeepPath' none is released on the way, so that the caller can restructure the path.
+    template <typename LockType>
+    void getLeafNode(const KeyType& key, ObjectUIDType& uidCurrentNode, ObjectTypePtr& ptrCurrentNode
+        , std::optional<KeyType>& keyLowerBound, std::optional<KeyType>& keyUpperBound
+        , std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vtAccessedNodes, std::vector<LockType>& vtLocks
+        , bool bKeepPath, bool bStrictlyBelow = false)
+    {
+        keyLowerBound = std::nullopt;
+        keyUpperBound = std::nullopt;
+
+#ifdef __CONCURRENT__
+        lockRootNode(uidCurrentNode, ptrCurrentNode, vtLocks);
+#else __CONCURRENT__
+        getRootNode(uidCurrentNode, ptrCurrentNode);
+#endif __CONCURRENT__
+
+        do
+        {
+#ifdef __BLINK_TREE__
+            std::optional<ObjectUIDType> uidRightSibling = getRightLink(ptrCurrentNode, key, bStrictlyBelow);
+            if (uidRightSibling)
+            {
+                keyLowerBound = getHighKey(ptrCurrentNode);
+
+                uidCurrentNode = *uidRightSibling;
+                ptrCurrentNode = nullptr;
+                m_ptrCache->getObject(uidCurrentNode, ptrCurrentNode);
+
+                if (ptrCurrentNode == nullptr)
+                {
+                    throw new std::exception("should not occur!");
+                }
+
+#ifdef __CONCURRENT__
+                LockType lock_sibling(ptrCurrentNode->mutex);
+                vtLocks.back().swap(lock_sibling);
+#endif __CONCURRENT__
+                continue;
+            }
+#endif __BLINK_TREE__
+
+            vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
+
+            if (!std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data))
+            {
+#ifdef __BLINK_TREE__
+                // The parent's pivot is stale if the leaf has been split since the parent was read.
+                keyUpperBound = getHighKey(ptrCurrentNode);
+#endif __BLINK_TREE__
+                break;
+            }
+
+            std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data);
+
+            ObjectTypePtr ptrLastNode = ptrCurrentNode;
+            uidCurrentNode = ptrIndexNode->getChild(key, keyLowerBound, keyUpperBound, bStrictlyBelow);
+
+            getChildNode(ptrLastNode, uidCurrentNode, ptrCurrentNode);
+
+#ifdef __CONCURRENT__
+            vtLocks.push_back(LockType(ptrCurrentNode->mutex));
+
+            if (!bKeepPath)
+            {
+                vtLocks.erase(vtLocks.begin());
+            }
+#endif __CONCURRENT__
+        } while (true);
+    }
+
+#ifdef __TREE_AWARE_CACHE__
+    // Counterpart of getLeafNode that takes no node locks, for a writer that already holds some on the way down.
+    void getLeafNode(const KeyType& key, ObjectUIDType& uidCurrentNode, ObjectTypePtr& ptrCurrentNode
+        , std::optional<KeyType>& keyLowerBound, std::optional<KeyType>& keyUpperBound
+        , std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vtAccessedNodes)
+    {
+        keyLowerBound = std::nullopt;
+        keyUpperBound = std::nullopt;
+
+        getRootNode(uidCurrentNode, ptrCurrentNode);
+
+        do
+        {
+            vtAccessedNodes.push_back(std::make_pair(uidCurrentNode, ptrCurrentNode));
+
+            if (!std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data))
+            {
+                break;
+            }
+
+            std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrCurrentNode->data);
+
+            ObjectTypePtr ptrLastNode = ptrCurrentNode;
+            uidCurrentNode = ptrIndexNode->getChild(key, keyLowerBound, keyUpperBound, false);
+
+            getChildNode(ptrLastNode, uidCurrentNode, ptrCurrentNode);
+        } while (true);
+    }
+#endif __TREE_AWARE_CACHE__
+
+    // Moves from the locked leaf to the one that follows it, preferring the sibling link over a descent from the root.
+    // 'lock_node' is handed over to the new leaf.
+    bool getNextLeafNode(ObjectUIDType& uidCurrentNode, ObjectTypePtr& ptrCurrentNode, std::shared_lock<VersionedSharedMutex>& lock_node)
+    {
+        std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+        std::optional<ObjectUIDType> uidNextNode = ptrDataNode->getNextSibling();
+
+        if (!uidNextNode)
+        {
+            return false;
+        }
+
+        ObjectTypePtr ptrNextNode = nullptr;
+        getSiblingNode(*uidNextNode, ptrNextNode);
+
+        if (ptrNextNode != nullptr)
+        {
+            std::shared_lock<VersionedSharedMutex> lock_next;
+
+#ifdef __CONCURRENT__
+            lock_next = std::shared_lock<VersionedSharedMutex>(ptrNextNode->mutex);
+#endif __CONCURRENT__
+
+            if (isPrevSibling(ptrNextNode, uidCurrentNode))
+            {
+                lock_node.swap(lock_next);
+
+                uidCurrentNode = *uidNextNode;
+                ptrCurrentNode = ptrNextNode;
+                return true;
+            }
+        }
+
+        // The link could not be followed (e.g. the sibling is not resident or has been relocated meanwhile),
+        // therefore, reach the next leaf from the root through the right fence of the current one.
+        KeyType keyLast = ptrDataNode->m_ptrData->m_vtKeys.back();
+
+#ifdef __CONCURRENT__
+        lock_node.unlock();
+#endif __CONCURRENT__
+
+        std::optional<KeyType> keyLowerBound = std::nullopt, keyUpperBound = std::nullopt;
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+        std::vector<std::shared_lock<VersionedSharedMutex>> vtLocks;
+
+        getLeafNode(keyLast, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtAccessedNodes, vtLocks, false);
+        vtLocks.clear();
+
+        if (!keyUpperBound)
+        {
+            return false;
+        }
+
+        KeyType keyFence = *keyUpperBound;
+        getLeafNode(keyFence, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtAccessedNodes, vtLocks, false);
+
+        m_ptrCache->reorder(vtAccessedNodes);
+
+#ifdef __CONCURRENT__
+        lock_node = std::move(vtLocks.back());
+#endif __CONCURRENT__
+
+        return true;
+    }
+
+    // Mirror of getNextLeafNode. The current leaf is released before the left one is locked, as writers and forward
+    // scans lock neighbouring leaves from left to right.
+    bool getPrevLeafNode(ObjectUIDType& uidCurrentNode, ObjectTypePtr& ptrCurrentNode, std::shared_lock<VersionedSharedMutex>& lock_node)
+    {
+        std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+        std::optional<ObjectUIDType> uidPrevNode = ptrDataNode->getPrevSibling();
+
+        if (!uidPrevNode)
+        {
+            return false;
+        }
+
+        KeyType keyFirst = ptrDataNode->m_ptrData->m_vtKeys.front();
+
+#ifdef __CONCURRENT__
+        lock_node.unlock();
+#endif __CONCURRENT__
+
+        ObjectTypePtr ptrPrevNode = nullptr;
+        getSiblingNode(*uidPrevNode, ptrPrevNode);
+
+        if (ptrPrevNode != nullptr)
+        {
+#ifdef __CONCURRENT__
+            lock_node = std::shared_lock<VersionedSharedMutex>(ptrPrevNode->mutex);
+#endif __CONCURRENT__
+
+            if (isNextSibling(ptrPrevNode, uidCurrentNode))
+            {
+                uidCurrentNode = *uidPrevNode;
+                ptrCurrentNode = ptrPrevNode;
+                return true;
+            }
+
+#ifdef __CONCURRENT__
+            lock_node.unlock();
+#endif __CONCURRENT__
+        }
+
+        std::optional<KeyType> keyLowerBound = std::nullopt, keyUpperBound = std::nullopt;
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+        std::vector<std::shared_lock<VersionedSharedMutex>> vtLocks;
+
+        getLeafNode(keyFirst, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtAccessedNodes, vtLocks, false);
+        vtLocks.clear();
+
+        if (!keyLowerBound)
+        {
+            return false;
+        }
+
+        KeyType keyFence = *keyLowerBound;
+        getLeafNode(keyFence, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtAccessedNodes, vtLocks, false, true);
+
+        m_ptrCache->reorder(vtAccessedNodes);
+
+#ifdef __CONCURRENT__
+        lock_node = std::move(vtLocks.back());
+#endif __CONCURRENT__
+
+        return true;
+    }
+
+    // Follows a sibling link; with the tree-aware cache only a resident sibling is returned, since loading it here would
+    // consume the uid update its parent is still waiting for.
+    void getSiblingNode(ObjectUIDType& uidSibling, ObjectTypePtr& ptrSibling)
+    {
+#ifdef __TREE_AWARE_CACHE__
+        resolveSiblingUID(uidSibling, false);
+
+        if (m_ptrCache->peekObject(uidSibling, ptrSibling) != CacheErrorCode::Success)
+        {
+            ptrSibling = nullptr;
+        }
+#else __TREE_AWARE_CACHE__
+        m_ptrCache->getObject(uidSibling, ptrSibling);
+#endif __TREE_AWARE_CACHE__
+    }
+
+    // A sibling link is trusted only if the node it leads to links back to the node it was taken from.
+    bool isPrevSibling(const ObjectTypePtr& ptrNode, const ObjectUIDType& uidPrevSibling)
+    {
+        if (!std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrNode->data))
+        {
+            return false;
+        }
+
+        std::optional<ObjectUIDType> uidLink = std::get<std::shared_ptr<DataNodeType>>(*ptrNode->data)->getPrevSibling();
+
+        if (!uidLink)
+        {
+            return false;
+        }
+
+#ifdef __TREE_AWARE_CACHE__
+        resolveSiblingUID(*uidLink, false);
+#endif __TREE_AWARE_CACHE__
+
+        return *uidLink == uidPrevSibling;
+    }
+
+    bool isNextSibling(const ObjectTypePtr& ptrNode, const ObjectUIDType& uidNextSibling)
+    {
+        if (!std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrNode->data))
+        {
+            return false;
+        }
+
+        std::optional<ObjectUIDType> uidLink = std::get<std::shared_ptr<DataNodeType>>(*ptrNode->data)->getNextSibling();
+
+        if (!uidLink)
+        {
+            return false;
+        }
+
+#ifdef __TREE_AWARE_CACHE__
+        resolveSiblingUID(*uidLink, false);
+#endif __TREE_AWARE_CACHE__
+
+        return *uidLink == uidNextSibling;
+    }
+
+    // Steps to the neighbouring entry. The pinned leaf is reused as long as the tree has not been restructured since the
+    // cursor was positioned and the cache still maps the leaf's uid to it; otherwise the position is re-found from the root.
+    ErrorCode moveCursor(Cursor& cursor, bool bForward)
+    {
+        if (!cursor.m_bValid)
+        {
+            return ErrorCode::KeyDoesNotExist;
+        }
+
+        ObjectUIDType uidCurrentNode = cursor.m_uidLeaf;
+        ObjectTypePtr ptrCurrentNode = cursor.m_ptrLeaf;
+
+        ObjectTypePtr ptrResidentNode = nullptr;
+        if (m_nStructureVersion.load() == cursor.m_nVersion
+            && m_ptrCache->peekObject(uidCurrentNode, ptrResidentNode) == CacheErrorCode::Success
+            && ptrResidentNode == ptrCurrentNode)
+        {
+            std::shared_lock<VersionedSharedMutex> lock_node;
+
+#ifdef __CONCURRENT__
+            lock_node = std::shared_lock<VersionedSharedMutex>(ptrCurrentNode->mutex);
+#endif __CONCURRENT__
+
+            // A writer may have restructured the leaf while this thread was waiting for it.
+            if (m_nStructureVersion.load() == cursor.m_nVersion)
+            {
+                std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+                // Entries may have been added to or removed from the leaf, hence the position is re-found by key.
+                size_t nIdx = bForward
+                    ? std::upper_bound(ptrDataNode->m_ptrData->m_vtKeys.begin(), ptrDataNode->m_ptrData->m_vtKeys.end(), cursor.m_key) - ptrDataNode->m_ptrData->m_vtKeys.begin()
+                    : std::lower_bound(ptrDataNode->m_ptrData->m_vtKeys.begin(), ptrDataNode->m_ptrData->m_vtKeys.end(), cursor.m_key) - ptrDataNode->m_ptrData->m_vtKeys.begin();
+
+                return positionCursor(cursor, uidCurrentNode, ptrCurrentNode, lock_node, nIdx, cursor.m_nVersion, bForward);
+            }
+        }
+
+        KeyType key = cursor.m_key;
+        return locateCursor(cursor, key, bForward, false);
+    }
+
+    // Positions the cursor from the root; forward it looks for the first key not less than (or, if not 'bInclusive',
+    // greater than) 'key', backward for the last key not greater than (or less than) 'key'.
+    ErrorCode locateCursor(Cursor& cursor, const KeyType& key, bool bForward, bool bInclusive)
+    {
+        cursor.reset();
+
+        // Read before the descent so that any restructuring that the descent might miss invalidates the position.
+        size_t nVersion = m_nStructureVersion.load();
+
+        ObjectUIDType uidCurrentNode;
+        ObjectTypePtr ptrCurrentNode = nullptr;
+        std::optional<KeyType> keyLowerBound = std::nullopt, keyUpperBound = std::nullopt;
+        std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+        std::vector<std::shared_lock<VersionedSharedMutex>> vtLocks;
+
+        getLeafNode(key, uidCurrentNode, ptrCurrentNode, keyLowerBound, keyUpperBound, vtAccessedNodes, vtLocks, false, !bForward && !bInclusive);
+
+        m_ptrCache->reorder(vtAccessedNodes);
+
+        std::shared_lock<VersionedSharedMutex> lock_node;
+
+#ifdef __CONCURRENT__
+        lock_node = std::move(vtLocks.back());
+#endif __CONCURRENT__
+
+        std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+        // Forward, 'nIdx' is the index of the entry to land on; backward, it is the number of entries before it.
+        size_t nIdx = (bForward == bInclusive)
+            ? std::lower_bound(ptrDataNode->m_ptrData->m_vtKeys.begin(), ptrDataNode->m_ptrData->m_vtKeys.end(), key) - ptrDataNode->m_ptrData->m_vtKeys.begin()
+            : std::upper_bound(ptrDataNode->m_ptrData->m_vtKeys.begin(), ptrDataNode->m_ptrData->m_vtKeys.end(), key) - ptrDataNode->m_ptrData->m_vtKeys.begin();
+
+        return positionCursor(cursor, uidCurrentNode, ptrCurrentNode, lock_node, nIdx, nVersion, bForward);
+    }
+
+    // Lands the cursor on entry 'nIdx' of the locked leaf (on entry 'nIdx - 1' when moving backward), hopping to the
+    // neighbouring leaves when the entry lies beyond the current one.
+    ErrorCode positionCursor(Cursor& cursor, ObjectUIDType uidCurrentNode, ObjectTypePtr ptrCurrentNode
+        , std::shared_lock<VersionedSharedMutex>& lock_node, size_t nIdx, size_t nVersion, bool bForward)
+    {
+        do
+        {
+            std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+            if (bForward && nIdx < ptrDataNode->m_ptrData->m_vtKeys.size())
+            {
+                break;
+            }
+
+            if (!bForward && nIdx > 0)
+            {
+                nIdx--;
+                break;
+            }
+
+            if (bForward ? !getNextLeafNode(uidCurrentNode, ptrCurrentNode, lock_node) : !getPrevLeafNode(uidCurrentNode, ptrCurrentNode, lock_node))
+            {
+                cursor.reset();
+                return ErrorCode::KeyDoesNotExist;
+            }
+
+            nIdx = bForward ? 0 : std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data)->m_ptrData->m_vtKeys.size();
+        } while (true);
+
+        std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrCurrentNode->data);
+
+        cursor.m_key = ptrDataNode->m_ptrData->m_vtKeys[nIdx];
+        cursor.m_value = ptrDataNode->m_ptrData->m_vtValues[nIdx];
+        cursor.m_uidLeaf = uidCurrentNode;
+        cursor.m_ptrLeaf = ptrCurrentNode;
+        cursor.m_nVersion = nVersion;
+        cursor.m_bValid = true;
+
+        return ErrorCode::Success;
+    }
+
+    // Points the back link of the leaf that follows 'key' (i.e. 'uidSibling') to 'uidPrevSibling' after a split or a merge.
+    void relinkPrevSibling(const KeyType& key, std::optional<ObjectUIDType> uidSibling, const ObjectUIDType& uidPrevSibling)
+    {
+        if (!uidSibling)
+        {
+            return;
+        }
+
+        ObjectTypePtr ptrSibling = nullptr;
+        getSiblingNode(*uidSibling, ptrSibling);
+
+#ifdef __TREE_AWARE_CACHE__
+        if (ptrSibling == nullptr)
+        {
+            std::optional<KeyType> keyLowerBound = std::nullopt, keyUpperBound = std::nullopt;
+            std::vector<std::pair<ObjectUIDType, ObjectTypePtr>> vtAccessedNodes;
+
+            getLeafNode(key, *uidSibling, ptrSibling, keyLowerBound, keyUpperBound, vtAccessedNodes);
+
+            if (!keyUpperBound)
+            {
+                throw new std::exception("should not occur!");
+            }
+
+            KeyType keyFence = *keyUpperBound;
+            getLeafNode(keyFence, *uidSibling, ptrSibling, keyLowerBound, keyUpperBound, vtAccessedNodes);
+
+            // Keeps the nodes just loaded behind their parents in the LRU order, as the flush expects.
+            m_ptrCache->reorder(vtAccessedNodes, false);
+        }
+#endif __TREE_AWARE_CACHE__
+
+#ifdef __CONCURRENT__
+        std::unique_lock<VersionedSharedMutex> lock_sibling(ptrSibling->mutex);
+#endif __CONCURRENT__
+
+        std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*ptrSibling->data);
+
+#ifdef __TREE_AWARE_CACHE__
+        std::optional<ObjectUIDType> uidReleased = ptrDataNode->getPrevSibling();
+        if (uidReleased)
+        {
+            resolveSiblingUID(*uidReleased, true);
+        }
+
+        ptrSibling->dirty = true;
+#endif __TREE_AWARE_CACHE__
+
+        ptrDataNode->setPrevSibling(uidPrevSibling);
+    }
+
+#ifdef __TREE_AWARE_CACHE__
+    // Walks the forwarding chain of a relocated leaf; 'bRelease' drops the caller's reference on every hop.
+    void resolveSiblingUID(ObjectUIDType& uid, bool bRelease)
+    {
+#ifdef __CONCURRENT__
+        std::unique_lock<std::mutex> lock(m_mtxSiblingUIDUpdates);
+#endif __CONCURRENT__
+
+        auto it = m_mpSiblingUIDUpdates.find(uid);
+        while (it != m_mpSiblingUIDUpdates.end())
+        {
+            uid = (*it).second.first;
+
+            if (bRelease && --(*it).second.second == 0)
+            {
+                m_mpSiblingUIDUpdates.erase(it);
+            }
+
+            it = m_mpSiblingUIDUpdates.find(uid);
+        }
+    }
+
+    void registerSiblingUIDUpdate(const ObjectUIDType& uidOld, const ObjectUIDType& uidNew)
+    {
+#ifdef __CONCURRENT__
+        std::unique_lock<std::mutex> lock(m_mtxSiblingUIDUpdates);
+#endif __CONCURRENT__
+
+        std::pair<ObjectUIDType, size_t>& prUpdate = m_mpSiblingUIDUpdates[uidOld];
+        prUpdate.first = uidNew;
+        prUpdate.second++;
+    }
+
+    void discardSiblingUIDUpdate(const ObjectUIDType& uid)
+    {
+#ifdef __CONCURRENT__
+        std::unique_lock<std::mutex> lock(m_mtxSiblingUIDUpdates);
+#endif __CONCURRENT__
+
+        m_mpSiblingUIDUpdates.erase(uid);
+    }
+
+    // Brings the sibling links of a leaf that is about to be flushed up to date; 'vtRelocatedSiblings' receives (per link)
+    // the sibling from the same batch that has already been relocated and still links to this leaf.
+    bool updateSiblingUIDs(std::shared_ptr<DataNodeType> ptrDataNode
+        , std::unordered_map<ObjectUIDType, std::pair<ObjectUIDType, std::shared_ptr<DataNodeType>>>& mpRelocatedLeaves
+        , std::shared_ptr<DataNodeType> (&vtRelocatedSiblings)[2])
+    {
+        bool bUpdated = false;
+
+        std::optional<ObjectUIDType> vtLinks[2] = { ptrDataNode->getPrevSibling(), ptrDataNode->getNextSibling() };
+
+        for (int idx = 0; idx < 2; idx++)
+        {
+            if (!vtLinks[idx])
+            {
+                continue;
+            }
+
+            ObjectUIDType uidLink = *vtLinks[idx];
+            resolveSiblingUID(uidLink, true);
+
+            auto it = mpRelocatedLeaves.find(uidLink);
+            if (it != mpRelocatedLeaves.end())
+            {
+                uidLink = (*it).second.first;
+                vtRelocatedSiblings[idx] = (*it).second.second;
+            }
+
+            if (!(uidLink == *vtLinks[idx]))
+            {
+                idx == 0 ? ptrDataNode->setPrevSibling(uidLink) : ptrDataNode->setNextSibling(uidLink);
+                bUpdated = true;
+            }
+        }
+
+        return bUpdated;
+    }
+#endif __TREE_AWARE_CACHE__
+
+#ifdef __TREE_AWARE_CACHE__
+public:
+    void applyExistingUpdates(std::shared_ptr<ObjectType> ptrObject
+        , std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUIDUpdates)
+    {
+        if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*ptrObject->data))
+        {
+            std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*ptrObject->data);
+
+            auto it = ptrIndexNode->m_ptrData->m_vtChildren.begin();
+            while (it != ptrIndexNode->m_ptrData->m_vtChildren.end())
+            {
+                if (mpUIDUpdates.find(*it) != mpUIDUpdates.end())
+                {
+                    ObjectUIDType uidTemp = *it;
+
+                    *it = *(mpUIDUpdates[*it].first);
+
+                    mpUIDUpdates.erase(uidTemp);
+
+                    ptrObject->dirty = true;
+                }
+                it++;
+            }
+        }
+        else //if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*ptrObject->data))
+        {
+            // Nothing to update in this case!
+        }
+    }
+
+    void applyExistingUpdates(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtNodes
+        , std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUIDUpdates)
+    {
+        auto it = vtNodes.begin();
+        while (it != vtNodes.end())
+        {
+            if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*(*it).second.second->data))
+            {
+                std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*(*it).second.second->data);
+
+                auto it_children = ptrIndexNode->m_ptrData->m_vtChildren.begin();
+                while (it_children != ptrIndexNode->m_ptrData->m_vtChildren.end())
+                {
+                    if (mpUIDUpdates.find(*it_children) != mpUIDUpdates.end())
+                    {
+                        ObjectUIDType uidTemp = *it_children;
+
+                        *it_children = *(mpUIDUpdates[*it_children].first);
+
+                        mpUIDUpdates.erase(uidTemp);
+
+                        (*it).second.second->dirty = true;
+                    }
+                    it_children++;
+                }
+            }
+            else //if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*(*it).second.second->data))
+            {
+                // Nothing to update in this case!
+            }
+            it++;
+        }
+    }
+
+    void prepareFlush(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtNodes
+        , size_t& nPos, size_t nBlockSize, ObjectUIDType::Media nMediaType)
+    {
+        std::vector<bool> vtAppliedUpdates;
+        vtAppliedUpdates.resize(vtNodes.size(), false);
+
+        // Leaves of this batch that are yet to be processed, and the ones relocated so far (old uid -> (new uid, node)).
+        std::unordered_set<ObjectUIDType> stPendingLeaves;
+        std::unordered_map<ObjectUIDType, std::pair<ObjectUIDType, std::shared_ptr<DataNodeType>>> mpRelocatedLeaves;
+
+        // Forwarding entries are published once the whole batch is processed so that they do not shadow mpRelocatedLeaves.
+        std::vector<std::pair<ObjectUIDType, ObjectUIDType>> vtSiblingUIDUpdates;
+
+        for (int idx = 0; idx < vtNodes.size(); idx++)
+        {
+            if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*vtNodes[idx].second.second->data))
+            {
+                stPendingLeaves.insert(vtNodes[idx].first);
+            }
+        }
+
+        for (int idx = 0; idx < vtNodes.size(); idx++)
+        {
+            if (std::holds_alternative<std::shared_ptr<IndexNodeType>>(*vtNodes[idx].second.second->data))
+            {
+                std::shared_ptr<IndexNodeType> ptrIndexNode = std::get<std::shared_ptr<IndexNodeType>>(*vtNodes[idx].second.second->data);
+
+                // The children relocated by this batch (child index -> batch index).
+                std::vector<std::pair<size_t, int>> vtChildUpdates;
+                bool bDeferred = false;
+
+                for (size_t nChildIdx = 0; nChildIdx < ptrIndexNode->m_ptrData->m_vtChildren.size(); nChildIdx++)
+                {
+                    const ObjectUIDType& uidChild = ptrIndexNode->m_ptrData->m_vtChildren[nChildIdx];
+
+                    int jdx = 0;
+                    for (; jdx < idx; jdx++)
+                    {
+                        // Deferred nodes (see below) have no new uid to hand out.
+                        if (vtAppliedUpdates[jdx] || !vtNodes[jdx].second.first)
+                            continue;
+
+                        if (uidChild == vtNodes[jdx].first)
+                        {
+                            vtChildUpdates.push_back(std::make_pair(nChildIdx, jdx));
+                            break;
+                        }
+                    }
+
+                    if (jdx == idx && uidChild.m_uid.m_nMediaType < ObjectUIDType::DRAM)
+                    {
+                        bDeferred = true;
+                    }
+                }
+
+                // A child that is neither written yet nor part of this batch (which a replacement policy other than LRU
+                // may leave behind) cannot be addressed on the storage; the node is then left without a new uid, and the
+                // cache is to keep it until the next flush. It is not pointed to the new uids of this batch either, as it
+                // is back in the cache before they are written; the children are found through the pending updates instead.
+                if (bDeferred)
+                {
+                    continue;
+                }
+
+                for (auto it = vtChildUpdates.begin(); it != vtChildUpdates.end(); it++)
+                {
+                    ptrIndexNode->m_ptrData->m_vtChildren[(*it).first] = *vtNodes[(*it).second].second.first;
+                    vtNodes[idx].second.second->dirty = true;
+
+                    vtAppliedUpdates[(*it).second] = true;
+                }
+
+                if (!vtNodes[idx].second.second->dirty)
+                {
+                    vtAppliedUpdates.erase(vtAppliedUpdates.begin() + idx);
+                    vtNodes.erase(vtNodes.begin() + idx); idx--;
+                    continue;
+                }
+
+                size_t nNodeSize = ptrIndexNode->getSize();
 
                 ObjectUIDType uidUpdated = ObjectUIDType::createAddressFromArgs(nMediaType, nPos, nBlockSize, nNodeSize);
 
@@ -801,14 +2910,23 @@ public:
             }
             else if (std::holds_alternative<std::shared_ptr<DataNodeType>>(*vtNodes[idx].second.second->data))
             {
+                std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*vtNodes[idx].second.second->data);
+
+                stPendingLeaves.erase(vtNodes[idx].first);
+
+                std::shared_ptr<DataNodeType> vtRelocatedSiblings[2] = { nullptr, nullptr };
+                if (updateSiblingUIDs(ptrDataNode, mpRelocatedLeaves, vtRelocatedSiblings))
+                {
+                    vtNodes[idx].second.second->dirty = true;
+                }
+
                 if (!vtNodes[idx].second.second->dirty)
                 {
+                    vtAppliedUpdates.erase(vtAppliedUpdates.begin() + idx);
                     vtNodes.erase(vtNodes.begin() + idx); idx--;
                     continue;
                 }
 
-                std::shared_ptr<DataNodeType> ptrDataNode = std::get<std::shared_ptr<DataNodeType>>(*vtNodes[idx].second.second->data);
-
                 size_t nNodeSize = ptrDataNode->getSize();
 
                 ObjectUIDType uidUpdated = ObjectUIDType::createAddressFromArgs(nMediaType, nPos, nBlockSize, nNodeSize);
@@ -816,8 +2934,30 @@ public:
                 vtNodes[idx].second.first = uidUpdated;
 
                 nPos += std::ceil(nNodeSize / (float)nBlockSize);
+
+                mpRelocatedLeaves[vtNodes[idx].first] = std::make_pair(uidUpdated, ptrDataNode);
+
+                // Siblings already relocated in this batch are patched in place, the pending ones patch themselves
+                // through mpRelocatedLeaves, and the ones outside the batch resolve the old uid via m_mpSiblingUIDUpdates.
+                std::optional<ObjectUIDType> vtLinks[2] = { ptrDataNode->getPrevSibling(), ptrDataNode->getNextSibling() };
+                for (int jdx = 0; jdx < 2; jdx++)
+                {
+                    if (vtRelocatedSiblings[jdx] != nullptr)
+                    {
+                        vtRelocatedSiblings[jdx]->updateSiblingUID(vtNodes[idx].first, uidUpdated);
+                    }
+                    else if (vtLinks[jdx] && stPendingLeaves.find(*vtLinks[jdx]) == stPendingLeaves.end())
+                    {
+                        vtSiblingUIDUpdates.push_back(std::make_pair(vtNodes[idx].first, uidUpdated));
+                    }
+                }
             }
         }
+
+        for (auto it = vtSiblingUIDUpdates.begin(); it != vtSiblingUIDUpdates.end(); it++)
+        {
+            registerSiblingUIDUpdate((*it).first, (*it).second);
+        }
     }
 #endif __TREE_AWARE_CACHE__
 };
\ No newline at end of file
@@ -5,32 +5,54 @@
 #include <map>
 #include <cmath>
 #include <optional>
+#include <type_traits>
 
 #include <iostream>
 #include <fstream>
 #include <assert.h>
 #include "ErrorCodes.h"
+#include "Prefetch.h"
+#include "NodeSearch.hpp"
+#include "InlineStorage.hpp"
 
-template <typename KeyType, typename ValueType, typename ObjectUIDType, uint8_t TYPE_UID>
+//#define __BLINK_TREE__
+
+// With a non-zero INLINE_DEGREE the entries live in cache-line-aligned arrays embedded in the node, sized for a node of that
+// degree plus the entry it holds until it is split, so that the whole node is a single allocation.
+template <typename KeyType, typename ValueType, typename ObjectUIDType, uint8_t TYPE_UID, size_t INLINE_DEGREE = 0>
 class DataNode
 {
 public:
 	static const uint8_t UID = TYPE_UID;
 
 private:
-	typedef DataNode<KeyType, ValueType, ObjectUIDType, TYPE_UID> SelfType;
+	typedef DataNode<KeyType, ValueType, ObjectUIDType, TYPE_UID, INLINE_DEGREE> SelfType;
+
+	typedef std::conditional_t<INLINE_DEGREE == 0, std::vector<KeyType>, InlineVector<KeyType, INLINE_DEGREE + 1>> KeyContainer;
+	typedef std::conditional_t<INLINE_DEGREE == 0, std::vector<ValueType>, InlineVector<ValueType, INLINE_DEGREE + 1>> ValueContainer;
 
-	typedef std::vector<KeyType>::const_iterator KeyTypeIterator;
-	typedef std::vector<ValueType>::const_iterator ValueTypeIterator;
+	typedef KeyContainer::const_iterator KeyTypeIterator;
+	typedef ValueContainer::const_iterator ValueTypeIterator;
 
 	struct DATANODESTRUCT
 	{
-		std::vector<KeyType> m_vtKeys;
-		std::vector<ValueType> m_vtValues;
+		KeyContainer m_vtKeys;
+		ValueContainer m_vtValues;
+
+		// Links to the neighbouring leaves, used by range scans to hop between leaves without re-descending.
+		std::optional<ObjectUIDType> m_uidPrevSibling;
+		std::optional<ObjectUIDType> m_uidNextSibling;
+
+#ifdef __BLINK_TREE__
+		// The lowest key of the next leaf; a key not less than it has been moved to the right by a split.
+		std::optional<KeyType> m_keyHigh;
+#endif __BLINK_TREE__
 	};
 
+	typedef std::conditional_t<INLINE_DEGREE == 0, std::shared_ptr<DATANODESTRUCT>, InlinePtr<DATANODESTRUCT>> DataPtrType;
+
 public:
-	std::shared_ptr<DATANODESTRUCT> m_ptrData;
+	DataPtrType m_ptrData;
 
 public:
 	~DataNode()
@@ -40,12 +62,12 @@ public:
 	}
 
 	DataNode()
-		: m_ptrData(make_shared<DATANODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 	}
 
 	DataNode(const DataNode& source)
-		: m_ptrData(make_shared<DATANODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 		for (const auto& obj : source.m_ptrData->m_vtKeys)
 		{
@@ -56,10 +78,17 @@ public:
 		{
 			m_ptrData->m_vtValues.push_back(ValueType(obj));
 		}
+
+		m_ptrData->m_uidPrevSibling = source.m_ptrData->m_uidPrevSibling;
+		m_ptrData->m_uidNextSibling = source.m_ptrData->m_uidNextSibling;
+
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = source.m_ptrData->m_keyHigh;
+#endif __BLINK_TREE__
 	}
 
 	DataNode(const char* szData)
-		: m_ptrData(make_shared<DATANODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 		size_t nKeyCount, nValueCount = 0;
 
@@ -80,10 +109,16 @@ public:
 
 		size_t nValuesSize = nValueCount * sizeof(ValueType);
 		memcpy(m_ptrData->m_vtValues.data(), szData + nOffset, nValuesSize);
+		nOffset += nValuesSize;
+
+		m_ptrData->m_uidPrevSibling = readSiblingUID(szData + nOffset);
+		nOffset += sizeof(ObjectUIDType::NodeUID);
+
+		m_ptrData->m_uidNextSibling = readSiblingUID(szData + nOffset);
 	}
 
 	DataNode(std::fstream& is)
-		: m_ptrData(make_shared<DATANODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 		size_t keyCount, valueCount;
 
@@ -95,26 +130,59 @@ public:
 
 		is.read(reinterpret_cast<char*>(m_ptrData->m_vtKeys.data()), keyCount * sizeof(KeyType));
 		is.read(reinterpret_cast<char*>(m_ptrData->m_vtValues.data()), valueCount * sizeof(ValueType));
+
+		char szSiblings[2 * sizeof(ObjectUIDType::NodeUID)];
+		is.read(szSiblings, 2 * sizeof(ObjectUIDType::NodeUID));
+
+		m_ptrData->m_uidPrevSibling = readSiblingUID(szSiblings);
+		m_ptrData->m_uidNextSibling = readSiblingUID(szSiblings + sizeof(ObjectUIDType::NodeUID));
 	}
 
-	DataNode(KeyTypeIterator itBeginKeys, KeyTypeIterator itEndKeys, ValueTypeIterator itBeginValues, ValueTypeIterator itEndValues)
-		: m_ptrData(make_shared<DATANODESTRUCT>())
+	template <typename KeyIterator, typename ValueIterator>
+	DataNode(KeyIterator itBeginKeys, KeyIterator itEndKeys, ValueIterator itBeginValues, ValueIterator itEndValues)
+		: m_ptrData(makeData())
 	{
 		m_ptrData->m_vtKeys.assign(itBeginKeys, itEndKeys);
 		m_ptrData->m_vtValues.assign(itBeginValues, itEndValues);
 	}
 
-	inline ErrorCode insert(const KeyType& key, const ValueType& value)
+	template <typename KeyIterator, typename ValueIterator>
+	DataNode(KeyIterator itBeginKeys, KeyIterator itEndKeys, ValueIterator itBeginValues, ValueIterator itEndValues
+		, std::optional<ObjectUIDType> uidPrevSibling, std::optional<ObjectUIDType> uidNextSibling)
+		: m_ptrData(makeData())
+	{
+		m_ptrData->m_vtKeys.assign(itBeginKeys, itEndKeys);
+		m_ptrData->m_vtValues.assign(itBeginValues, itEndValues);
+
+		m_ptrData->m_uidPrevSibling = uidPrevSibling;
+		m_ptrData->m_uidNextSibling = uidNextSibling;
+	}
+
+#ifdef __BLINK_TREE__
+	template <typename KeyIterator, typename ValueIterator>
+	DataNode(KeyIterator itBeginKeys, KeyIterator itEndKeys, ValueIterator itBeginValues, ValueIterator itEndValues
+		, std::optional<ObjectUIDType> uidPrevSibling, std::optional<ObjectUIDType> uidNextSibling, std::optional<KeyType> keyHigh)
+		: DataNode(itBeginKeys, itEndKeys, itBeginValues, itEndValues, uidPrevSibling, uidNextSibling)
+	{
+		m_ptrData->m_keyHigh = keyHigh;
+	}
+#endif __BLINK_TREE__
+
+	static inline DataPtrType makeData()
 	{
-		size_t nChildIdx = m_ptrData->m_vtKeys.size();
-		for (int nIdx = 0; nIdx < m_ptrData->m_vtKeys.size(); ++nIdx)
+		if constexpr (INLINE_DEGREE == 0)
 		{
-			if (key < m_ptrData->m_vtKeys[nIdx])
-			{
-				nChildIdx = nIdx;
-				break;
-			}
+			return make_shared<DATANODESTRUCT>();
 		}
+		else
+		{
+			return DataPtrType();
+		}
+	}
+
+	inline ErrorCode insert(const KeyType& key, const ValueType& value)
+	{
+		size_t nChildIdx = NodeSearch<KeyType>::upperBound(m_ptrData->m_vtKeys.data(), m_ptrData->m_vtKeys.size(), key);
 
 		m_ptrData->m_vtKeys.insert(m_ptrData->m_vtKeys.begin() + nChildIdx, key);
 		m_ptrData->m_vtValues.insert(m_ptrData->m_vtValues.begin() + nChildIdx, value);
@@ -124,7 +192,7 @@ public:
 
 	inline ErrorCode remove(const KeyType& key)
 	{
-		KeyTypeIterator it = std::lower_bound(m_ptrData->m_vtKeys.begin(), m_ptrData->m_vtKeys.end(), key);
+		KeyTypeIterator it = m_ptrData->m_vtKeys.begin() + NodeSearch<KeyType>::lowerBound(m_ptrData->m_vtKeys.data(), m_ptrData->m_vtKeys.size(), key);
 
 		if (it != m_ptrData->m_vtKeys.end() && *it == key)
 		{
@@ -138,6 +206,71 @@ public:
 		return ErrorCode::KeyDoesNotExist;
 	}
 
+	// Merges the entries in [itBegin, itEnd), which must be sorted by key, into the node in a single pass.
+	template <typename EntryIterator>
+	inline ErrorCode insertBatch(EntryIterator itBegin, EntryIterator itEnd)
+	{
+		KeyContainer vtKeys;
+		ValueContainer vtValues;
+
+		vtKeys.reserve(m_ptrData->m_vtKeys.size() + std::distance(itBegin, itEnd));
+		vtValues.reserve(vtKeys.capacity());
+
+		size_t nIdx = 0;
+		for (EntryIterator it = itBegin; it != itEnd; it++)
+		{
+			while (nIdx < m_ptrData->m_vtKeys.size() && !((*it).first < m_ptrData->m_vtKeys[nIdx]))
+			{
+				vtKeys.push_back(m_ptrData->m_vtKeys[nIdx]);
+				vtValues.push_back(m_ptrData->m_vtValues[nIdx]);
+				nIdx++;
+			}
+
+			vtKeys.push_back((*it).first);
+			vtValues.push_back((*it).second);
+		}
+
+		vtKeys.insert(vtKeys.end(), m_ptrData->m_vtKeys.begin() + nIdx, m_ptrData->m_vtKeys.end());
+		vtValues.insert(vtValues.end(), m_ptrData->m_vtValues.begin() + nIdx, m_ptrData->m_vtValues.end());
+
+		m_ptrData->m_vtKeys.swap(vtKeys);
+		m_ptrData->m_vtValues.swap(vtValues);
+
+		return ErrorCode::Success;
+	}
+
+	// Removes the keys in [itBegin, itEnd), which must be sorted, in a single pass; returns the number of keys found.
+	template <typename KeyIterator>
+	inline size_t removeBatch(KeyIterator itBegin, KeyIterator itEnd)
+	{
+		size_t nRemoved = 0, nWriteIdx = 0;
+
+		KeyIterator it = itBegin;
+		for (size_t nIdx = 0; nIdx < m_ptrData->m_vtKeys.size(); nIdx++)
+		{
+			while (it != itEnd && *it < m_ptrData->m_vtKeys[nIdx])
+			{
+				it++;
+			}
+
+			if (it != itEnd && *it == m_ptrData->m_vtKeys[nIdx])
+			{
+				nRemoved++;
+				it++;
+				continue;
+			}
+
+			m_ptrData->m_vtKeys[nWriteIdx] = m_ptrData->m_vtKeys[nIdx];
+			m_ptrData->m_vtValues[nWriteIdx] = m_ptrData->m_vtValues[nIdx];
+			nWriteIdx++;
+		}
+
+		m_ptrData->m_vtKeys.resize(nWriteIdx);
+		m_ptrData->m_vtValues.resize(nWriteIdx);
+
+		return nRemoved;
+	}
+
 	inline bool requireSplit(size_t nDegree)
 	{
 		return m_ptrData->m_vtKeys.size() > nDegree;
@@ -152,9 +285,14 @@ public:
 		return m_ptrData->m_vtKeys.size();
 	}
 
+	inline void prefetch()
+	{
+		PREFETCH(m_ptrData->m_vtKeys.data());
+	}
+
 	inline ErrorCode getValue(const KeyType& key, ValueType& value)
 	{
-		KeyTypeIterator it = std::lower_bound(m_ptrData->m_vtKeys.begin(), m_ptrData->m_vtKeys.end(), key);
+		KeyTypeIterator it = m_ptrData->m_vtKeys.begin() + NodeSearch<KeyType>::lowerBound(m_ptrData->m_vtKeys.data(), m_ptrData->m_vtKeys.size(), key);
 		if (it != m_ptrData->m_vtKeys.end() && *it == key)
 		{
 			size_t index = it - m_ptrData->m_vtKeys.begin();
@@ -166,22 +304,113 @@ public:
 		return ErrorCode::KeyDoesNotExist;
 	}
 
+	template <typename Callback>
+	inline bool scan(const KeyType& keyBegin, const KeyType& keyEnd, Callback& fnCallback)
+	{
+		KeyTypeIterator it = m_ptrData->m_vtKeys.begin() + NodeSearch<KeyType>::lowerBound(m_ptrData->m_vtKeys.data(), m_ptrData->m_vtKeys.size(), keyBegin);
+
+		size_t nIdx = it - m_ptrData->m_vtKeys.begin();
+		for (; nIdx < m_ptrData->m_vtKeys.size(); nIdx++)
+		{
+			if (!(m_ptrData->m_vtKeys[nIdx] < keyEnd))
+			{
+				return false;
+			}
+
+			if (!fnCallback(m_ptrData->m_vtKeys[nIdx], m_ptrData->m_vtValues[nIdx]))
+			{
+				return false;
+			}
+		}
+
+		// The range may continue in the next leaf.
+		return true;
+	}
+
+	inline const std::optional<ObjectUIDType>& getPrevSibling()
+	{
+		return m_ptrData->m_uidPrevSibling;
+	}
+
+	inline const std::optional<ObjectUIDType>& getNextSibling()
+	{
+		return m_ptrData->m_uidNextSibling;
+	}
+
+	inline void setPrevSibling(const std::optional<ObjectUIDType>& uidSibling)
+	{
+		m_ptrData->m_uidPrevSibling = uidSibling;
+	}
+
+	inline void setNextSibling(const std::optional<ObjectUIDType>& uidSibling)
+	{
+		m_ptrData->m_uidNextSibling = uidSibling;
+	}
+
+#ifdef __BLINK_TREE__
+	inline const std::optional<KeyType>& getHighKey()
+	{
+		return m_ptrData->m_keyHigh;
+	}
+
+	inline void setHighKey(const std::optional<KeyType>& keyHigh)
+	{
+		m_ptrData->m_keyHigh = keyHigh;
+	}
+#endif __BLINK_TREE__
+
+	inline bool updateSiblingUID(const ObjectUIDType& uidOld, const ObjectUIDType& uidNew)
+	{
+		bool bUpdated = false;
+
+		if (m_ptrData->m_uidPrevSibling && *m_ptrData->m_uidPrevSibling == uidOld)
+		{
+			m_ptrData->m_uidPrevSibling = uidNew;
+			bUpdated = true;
+		}
+
+		if (m_ptrData->m_uidNextSibling && *m_ptrData->m_uidNextSibling == uidOld)
+		{
+			m_ptrData->m_uidNextSibling = uidNew;
+			bUpdated = true;
+		}
+
+		return bUpdated;
+	}
+
 	template <typename Cache, typename CacheKeyType>
-	inline ErrorCode split(Cache ptrCache, std::optional<CacheKeyType>& uidSibling, KeyType& pivotKeyForParent)
+	inline ErrorCode split(Cache ptrCache, const CacheKeyType& uidSelf, std::optional<CacheKeyType>& uidSibling, KeyType& pivotKeyForParent)
 	{
-		size_t nMid = m_ptrData->m_vtKeys.size() / 2;
+		return split<Cache, CacheKeyType>(ptrCache, uidSelf, uidSibling, pivotKeyForParent, m_ptrData->m_vtKeys.size() / 2);
+	}
 
+	// Moves the entries from 'nMid' onwards to the new sibling.
+	template <typename Cache, typename CacheKeyType>
+	inline ErrorCode split(Cache ptrCache, const CacheKeyType& uidSelf, std::optional<CacheKeyType>& uidSibling, KeyType& pivotKeyForParent, size_t nMid)
+	{
 		ptrCache->template createObjectOfType<SelfType>(uidSibling,
 			m_ptrData->m_vtKeys.begin() + nMid, m_ptrData->m_vtKeys.end(),
-			m_ptrData->m_vtValues.begin() + nMid, m_ptrData->m_vtValues.end());
+			m_ptrData->m_vtValues.begin() + nMid, m_ptrData->m_vtValues.end(),
+#ifdef __BLINK_TREE__
+			std::optional<CacheKeyType>(uidSelf), m_ptrData->m_uidNextSibling, m_ptrData->m_keyHigh);
+#else __BLINK_TREE__
+			std::optional<CacheKeyType>(uidSelf), m_ptrData->m_uidNextSibling);
+#endif __BLINK_TREE__
 
 		if (!uidSibling)
 		{
 			return ErrorCode::Error;
 		}
 
+		// The caller is responsible for pointing the former next sibling's back link to the new node.
+		m_ptrData->m_uidNextSibling = uidSibling;
+
 		pivotKeyForParent = m_ptrData->m_vtKeys[nMid];
 
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = pivotKeyForParent;
+#endif __BLINK_TREE__
+
 		m_ptrData->m_vtKeys.resize(nMid);
 		m_ptrData->m_vtValues.resize(nMid);
 
@@ -205,6 +434,10 @@ public:
 		m_ptrData->m_vtValues.insert(m_ptrData->m_vtValues.begin(), value);
 
 		pivotKeyForParent = key;
+
+#ifdef __BLINK_TREE__
+		ptrLHSSibling->m_ptrData->m_keyHigh = pivotKeyForParent;
+#endif __BLINK_TREE__
 	}
 
 	inline void moveAnEntityFromRHSSibling(std::shared_ptr<SelfType> ptrRHSSibling, KeyType& pivotKeyForParent)
@@ -224,12 +457,23 @@ public:
 		m_ptrData->m_vtValues.push_back(value);
 
 		pivotKeyForParent = ptrRHSSibling->m_ptrData->m_vtKeys.front();
+
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = pivotKeyForParent;
+#endif __BLINK_TREE__
 	}
 
 	inline void mergeNode(std::shared_ptr<SelfType> ptrSibling)
 	{
 		m_ptrData->m_vtKeys.insert(m_ptrData->m_vtKeys.end(), ptrSibling->m_ptrData->m_vtKeys.begin(), ptrSibling->m_ptrData->m_vtKeys.end());
 		m_ptrData->m_vtValues.insert(m_ptrData->m_vtValues.end(), ptrSibling->m_ptrData->m_vtValues.begin(), ptrSibling->m_ptrData->m_vtValues.end());
+
+		// The caller is responsible for pointing the absorbed node's next sibling back to this node.
+		m_ptrData->m_uidNextSibling = ptrSibling->m_ptrData->m_uidNextSibling;
+
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = ptrSibling->m_ptrData->m_keyHigh;
+#endif __BLINK_TREE__
 	}
 
 public:
@@ -240,7 +484,8 @@ public:
 			+ sizeof(size_t)
 			+ sizeof(size_t)
 			+ (m_ptrData->m_vtKeys.size() * sizeof(KeyType))
-			+ (m_ptrData->m_vtValues.size() * sizeof(ObjectUIDType::NodeUID));
+			+ (m_ptrData->m_vtValues.size() * sizeof(ObjectUIDType::NodeUID))
+			+ (2 * sizeof(ObjectUIDType::NodeUID));
 	}
 
 	inline void serialize(char*& szBuffer, uint8_t& uidObjectType, size_t& nBufferSize)
@@ -257,7 +502,7 @@ public:
 		size_t nKeyCount = m_ptrData->m_vtKeys.size();
 		size_t nValueCount = m_ptrData->m_vtValues.size();
 
-		nBufferSize = sizeof(uint8_t) + (nKeyCount * sizeof(KeyType)) + (nValueCount * sizeof(ValueType)) + sizeof(size_t) + sizeof(size_t);
+		nBufferSize = sizeof(uint8_t) + (nKeyCount * sizeof(KeyType)) + (nValueCount * sizeof(ValueType)) + sizeof(size_t) + sizeof(size_t) + (2 * sizeof(ObjectUIDType::NodeUID));
 
 		szBuffer = new char[nBufferSize + 1];
 		memset(szBuffer, '\0', nBufferSize + 1);
@@ -280,6 +525,12 @@ public:
 		memcpy(szBuffer + nOffset, m_ptrData->m_vtValues.data(), nValuesSize);
 		nOffset += nValuesSize;
 
+		writeSiblingUID(szBuffer + nOffset, m_ptrData->m_uidPrevSibling);
+		nOffset += sizeof(ObjectUIDType::NodeUID);
+
+		writeSiblingUID(szBuffer + nOffset, m_ptrData->m_uidNextSibling);
+		nOffset += sizeof(ObjectUIDType::NodeUID);
+
 		assert(nBufferSize == nOffset);
 
 		SelfType* _t = new SelfType(szBuffer);
@@ -317,13 +568,43 @@ public:
 		size_t nKeyCount = m_ptrData->m_vtKeys.size();
 		size_t nValueCount = m_ptrData->m_vtValues.size();
 
-		nDataSize = sizeof(uint8_t) + (nKeyCount * sizeof(KeyType)) + (nValueCount * sizeof(ValueType)) + sizeof(size_t) + sizeof(size_t);
+		nDataSize = sizeof(uint8_t) + (nKeyCount * sizeof(KeyType)) + (nValueCount * sizeof(ValueType)) + sizeof(size_t) + sizeof(size_t) + (2 * sizeof(ObjectUIDType::NodeUID));
+
+		char szSiblings[2 * sizeof(ObjectUIDType::NodeUID)];
+		writeSiblingUID(szSiblings, m_ptrData->m_uidPrevSibling);
+		writeSiblingUID(szSiblings + sizeof(ObjectUIDType::NodeUID), m_ptrData->m_uidNextSibling);
 
 		os.write(reinterpret_cast<const char*>(&UID), sizeof(uint8_t));
 		os.write(reinterpret_cast<const char*>(&nKeyCount), sizeof(size_t));
 		os.write(reinterpret_cast<const char*>(&nValueCount), sizeof(size_t));
 		os.write(reinterpret_cast<const char*>(m_ptrData->m_vtKeys.data()), nKeyCount * sizeof(KeyType));
 		os.write(reinterpret_cast<const char*>(m_ptrData->m_vtValues.data()), nValueCount * sizeof(ValueType));
+		os.write(szSiblings, 2 * sizeof(ObjectUIDType::NodeUID));
+	}
+
+private:
+	// A missing sibling is persisted as a zeroed NodeUID, i.e. with media type 'None'.
+	static inline void writeSiblingUID(char* szBuffer, const std::optional<ObjectUIDType>& uidSibling)
+	{
+		memset(szBuffer, 0, sizeof(ObjectUIDType::NodeUID));
+
+		if (uidSibling)
+		{
+			memcpy(szBuffer, &(*uidSibling).m_uid, sizeof(ObjectUIDType::NodeUID));
+		}
+	}
+
+	static inline std::optional<ObjectUIDType> readSiblingUID(const char* szBuffer)
+	{
+		ObjectUIDType uidSibling;
+		memcpy(&uidSibling.m_uid, szBuffer, sizeof(ObjectUIDType::NodeUID));
+
+		if (uidSibling.m_uid.m_nMediaType == ObjectUIDType::None)
+		{
+			return std::nullopt;
+		}
+
+		return uidSibling;
 	}
 
 public:
@@ -8,52 +8,94 @@
 #include <iostream>
 #include <cmath>
 #include <optional>
+#include <type_traits>
+#include <atomic>
 
 #include <iostream>
 #include <fstream>
 #include <assert.h>
 
 #include "ErrorCodes.h"
+#include "Prefetch.h"
+#include "NodeSearch.hpp"
+#include "InlineStorage.hpp"
 
 //#define __TREE_AWARE_CACHE__
+//#define __BLINK_TREE__
 
 using namespace std;
 
-template <typename KeyType, typename ValueType, typename ObjectUIDType, uint8_t TYPE_UID>
+// With a non-zero INLINE_DEGREE the pivots and children live in cache-line-aligned arrays embedded in the node, sized for a
+// node of that degree plus the pivot it holds until it is split, so that the whole node is a single allocation.
+template <typename KeyType, typename ValueType, typename ObjectUIDType, uint8_t TYPE_UID, size_t INLINE_DEGREE = 0>
 class IndexNode
 {
 public:
 	static const uint8_t UID = TYPE_UID;
 	
 private:
-	typedef IndexNode<KeyType, ValueType, ObjectUIDType, UID> SelfType;
+	typedef IndexNode<KeyType, ValueType, ObjectUIDType, UID, INLINE_DEGREE> SelfType;
 
-	typedef std::vector<KeyType>::const_iterator KeyTypeIterator;
-	typedef std::vector<ObjectUIDType>::const_iterator CacheKeyTypeIterator;
+	typedef std::conditional_t<INLINE_DEGREE == 0, std::vector<KeyType>, InlineVector<KeyType, INLINE_DEGREE + 1>> KeyContainer;
+	typedef std::conditional_t<INLINE_DEGREE == 0, std::vector<ObjectUIDType>, InlineVector<ObjectUIDType, INLINE_DEGREE + 2>> ChildContainer;
 
 public:
 	struct INDEXNODESTRUCT
 	{
-		std::vector<KeyType> m_vtPivots;
-		std::vector<ObjectUIDType> m_vtChildren;
+		KeyContainer m_vtPivots;
+		ChildContainer m_vtChildren;
+
+#ifdef __BLINK_TREE__
+		// The lowest key of the right sibling and the link to it; a key not less than the high key has been moved to the
+		// right by a split that the parent may not reflect yet.
+		std::optional<KeyType> m_keyHigh;
+		std::optional<ObjectUIDType> m_uidRightSibling;
+#endif __BLINK_TREE__
 	};
 
-	std::shared_ptr<INDEXNODESTRUCT> m_ptrData;
+	typedef std::conditional_t<INLINE_DEGREE == 0, std::shared_ptr<INDEXNODESTRUCT>, InlinePtr<INDEXNODESTRUCT>> DataPtrType;
+
+	DataPtrType m_ptrData;
+
+#ifdef __TREE_AWARE_CACHE__
+private:
+	struct SwizzledChild
+	{
+		ObjectUIDType m_uidChild;
+		std::weak_ptr<void> m_ptrChild;
+	};
+
+	struct SwizzleTable
+	{
+		size_t m_nMask;
+		std::unique_ptr<std::atomic<std::shared_ptr<SwizzledChild>>[]> m_ptrSlots;
+	};
+
+	// Swizzled references to the resident children, i.e. their in-memory objects, in a direct-mapped table keyed by the
+	// child's uid; they are neither serialized nor copied. An entry is only a hint, as the child may have been evicted since
+	// it was swizzled, which the cache tells. The table is allocated on the first swizzle, and the readers swizzle under a
+	// shared latch, hence the slots are atomic.
+	std::atomic<SwizzleTable*> m_ptrSwizzled = nullptr;
+#endif __TREE_AWARE_CACHE__
 
 public:
 	~IndexNode()
 	{
 		// TODO: check for ref count?
 		m_ptrData.reset();
+
+#ifdef __TREE_AWARE_CACHE__
+		delete m_ptrSwizzled.load();
+#endif __TREE_AWARE_CACHE__
 	}
 
 	IndexNode()
-		: m_ptrData(make_shared<INDEXNODESTRUCT>())
+		: m_ptrData(makeData())
 	{	
 	}
 
 	IndexNode(const IndexNode& source)
-		: m_ptrData(make_shared<INDEXNODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 		for (const auto& obj : source.m_ptrData->m_vtPivots)
 		{
@@ -64,10 +106,15 @@ public:
 		{
 			m_ptrData->m_vtChildren.push_back(ObjectUIDType(obj));
 		}
+
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = source.m_ptrData->m_keyHigh;
+		m_ptrData->m_uidRightSibling = source.m_ptrData->m_uidRightSibling;
+#endif __BLINK_TREE__
 	}
 
 	IndexNode(const char* szData)
-		: m_ptrData(make_shared<INDEXNODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 		size_t nKeyCount, nValueCount = 0;
 
@@ -91,7 +138,7 @@ public:
 	}
 
 	IndexNode(std::fstream& is)
-		: m_ptrData(make_shared<INDEXNODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 		size_t nKeyCount, nValueCount;
 		is.read(reinterpret_cast<char*>(&nKeyCount), sizeof(size_t));
@@ -104,32 +151,48 @@ public:
 		is.read(reinterpret_cast<char*>(m_ptrData->m_vtChildren.data()), nValueCount * sizeof(ObjectUIDType::NodeUID));
 	}
 
-	IndexNode(KeyTypeIterator itBeginPivots, KeyTypeIterator itEndPivots, CacheKeyTypeIterator itBeginChildren, CacheKeyTypeIterator itEndChildren)
-		: m_ptrData(make_shared<INDEXNODESTRUCT>())
+	template <typename KeyIterator, typename CacheKeyIterator>
+	IndexNode(KeyIterator itBeginPivots, KeyIterator itEndPivots, CacheKeyIterator itBeginChildren, CacheKeyIterator itEndChildren)
+		: m_ptrData(makeData())
 	{
 		m_ptrData->m_vtPivots.assign(itBeginPivots, itEndPivots);
 		m_ptrData->m_vtChildren.assign(itBeginChildren, itEndChildren);
 	}
 
+#ifdef __BLINK_TREE__
+	template <typename KeyIterator, typename CacheKeyIterator>
+	IndexNode(KeyIterator itBeginPivots, KeyIterator itEndPivots, CacheKeyIterator itBeginChildren, CacheKeyIterator itEndChildren
+		, std::optional<KeyType> keyHigh, std::optional<ObjectUIDType> uidRightSibling)
+		: IndexNode(itBeginPivots, itEndPivots, itBeginChildren, itEndChildren)
+	{
+		m_ptrData->m_keyHigh = keyHigh;
+		m_ptrData->m_uidRightSibling = uidRightSibling;
+	}
+#endif __BLINK_TREE__
+
 	IndexNode(const KeyType& pivotKey, const ObjectUIDType& ptrLHSNode, const ObjectUIDType& ptrRHSNode)
-		: m_ptrData(make_shared<INDEXNODESTRUCT>())
+		: m_ptrData(makeData())
 	{
 		m_ptrData->m_vtPivots.push_back(pivotKey);
 		m_ptrData->m_vtChildren.push_back(ptrLHSNode);
 		m_ptrData->m_vtChildren.push_back(ptrRHSNode);
 	}
 
-	inline ErrorCode insert(const KeyType& pivotKey, const ObjectUIDType& uidSibling)
+	static inline DataPtrType makeData()
 	{
-		size_t nChildIdx = m_ptrData->m_vtPivots.size();
-		for (int nIdx = 0; nIdx < m_ptrData->m_vtPivots.size(); ++nIdx)
+		if constexpr (INLINE_DEGREE == 0)
 		{
-			if (pivotKey < m_ptrData->m_vtPivots[nIdx])
-			{
-				nChildIdx = nIdx;
-				break;
-			}
+			return make_shared<INDEXNODESTRUCT>();
 		}
+		else
+		{
+			return DataPtrType();
+		}
+	}
+
+	inline ErrorCode insert(const KeyType& pivotKey, const ObjectUIDType& uidSibling)
+	{
+		size_t nChildIdx = NodeSearch<KeyType>::upperBound(m_ptrData->m_vtPivots.data(), m_ptrData->m_vtPivots.size(), pivotKey);
 
 		m_ptrData->m_vtPivots.insert(m_ptrData->m_vtPivots.begin() + nChildIdx, pivotKey);
 		m_ptrData->m_vtChildren.insert(m_ptrData->m_vtChildren.begin() + nChildIdx + 1, uidSibling);
@@ -318,6 +381,52 @@ public:
 		throw new exception("should not occur!"); // TODO: critical log entry.
 	}
 
+#ifdef __TREE_AWARE_CACHE__
+	// The object that 'uidChild' was last swizzled to, if it is still alive; the caller has to validate it with the cache.
+	inline std::shared_ptr<void> getSwizzledChild(const ObjectUIDType& uidChild) const
+	{
+		SwizzleTable* ptrTable = m_ptrSwizzled.load(std::memory_order_acquire);
+		if (ptrTable == nullptr)
+		{
+			return nullptr;
+		}
+
+		std::shared_ptr<SwizzledChild> ptrEntry = ptrTable->m_ptrSlots[std::hash<ObjectUIDType>()(uidChild) & ptrTable->m_nMask].load();
+		if (ptrEntry == nullptr || !(ptrEntry->m_uidChild == uidChild))
+		{
+			return nullptr;
+		}
+
+		return ptrEntry->m_ptrChild.lock();
+	}
+
+	inline void swizzleChild(const ObjectUIDType& uidChild, const std::shared_ptr<void>& ptrChild)
+	{
+		SwizzleTable* ptrTable = m_ptrSwizzled.load(std::memory_order_acquire);
+		if (ptrTable == nullptr)
+		{
+			// Twice the fan-out, so that the children rarely share a slot.
+			size_t nSize = 8;
+			while (nSize < 2 * m_ptrData->m_vtChildren.size())
+			{
+				nSize <<= 1;
+			}
+
+			SwizzleTable* ptrNewTable = new SwizzleTable{ nSize - 1, std::make_unique<std::atomic<std::shared_ptr<SwizzledChild>>[]>(nSize) };
+			if (m_ptrSwizzled.compare_exchange_strong(ptrTable, ptrNewTable, std::memory_order_acq_rel))
+			{
+				ptrTable = ptrNewTable;
+			}
+			else
+			{
+				delete ptrNewTable;
+			}
+		}
+
+		ptrTable->m_ptrSlots[std::hash<ObjectUIDType>()(uidChild) & ptrTable->m_nMask].store(std::make_shared<SwizzledChild>(SwizzledChild{ uidChild, ptrChild }));
+	}
+#endif __TREE_AWARE_CACHE__
+
 	inline size_t getKeysCount() 
 	{
 		return m_ptrData->m_vtPivots.size();
@@ -325,13 +434,20 @@ public:
 
 	inline size_t getChildNodeIdx(const KeyType& key)
 	{
-		size_t nChildIdx = 0;
-		while (nChildIdx < m_ptrData->m_vtPivots.size() && key >= m_ptrData->m_vtPivots[nChildIdx])
-		{
-			nChildIdx++;
-		}
+		return NodeSearch<KeyType>::upperBound(m_ptrData->m_vtPivots.data(), m_ptrData->m_vtPivots.size(), key);
+	}
 
-		return nChildIdx;
+	// Resumes the search at 'nFromIdx', which is the child of a key not greater than 'key'; a run of ascending keys thus
+	// searches a shrinking range of the pivots.
+	inline size_t getChildNodeIdx(const KeyType& key, size_t nFromIdx)
+	{
+		return nFromIdx + NodeSearch<KeyType>::upperBound(m_ptrData->m_vtPivots.data() + nFromIdx, m_ptrData->m_vtPivots.size() - nFromIdx, key);
+	}
+
+	inline void prefetch()
+	{
+		PREFETCH(m_ptrData->m_vtPivots.data());
+		PREFETCH(m_ptrData->m_vtChildren.data());
 	}
 
 	inline ObjectUIDType getChildAt(size_t nIdx) 
@@ -344,11 +460,54 @@ public:
 		return m_ptrData->m_vtChildren[getChildNodeIdx(key)];
 	}
 
+	// Also narrows 'keyLowerBound' and 'keyUpperBound' to the pivots that bound the chosen child, if any. With 'bStrictlyBelow'
+	// the child that holds the greatest key less than 'key' is chosen instead.
+	inline ObjectUIDType getChild(const KeyType& key, std::optional<KeyType>& keyLowerBound, std::optional<KeyType>& keyUpperBound, bool bStrictlyBelow = false)
+	{
+		size_t nChildIdx = bStrictlyBelow
+			? NodeSearch<KeyType>::lowerBound(m_ptrData->m_vtPivots.data(), m_ptrData->m_vtPivots.size(), key)
+			: getChildNodeIdx(key);
+
+		if (nChildIdx > 0)
+		{
+			keyLowerBound = m_ptrData->m_vtPivots[nChildIdx - 1];
+		}
+
+		if (nChildIdx < m_ptrData->m_vtPivots.size())
+		{
+			keyUpperBound = m_ptrData->m_vtPivots[nChildIdx];
+		}
+
+		return m_ptrData->m_vtChildren[nChildIdx];
+	}
+
 	inline bool requireSplit(size_t nDegree)
 	{
 		return m_ptrData->m_vtPivots.size() > nDegree;
 	}
 
+#ifdef __BLINK_TREE__
+	inline const std::optional<KeyType>& getHighKey()
+	{
+		return m_ptrData->m_keyHigh;
+	}
+
+	inline void setHighKey(const std::optional<KeyType>& keyHigh)
+	{
+		m_ptrData->m_keyHigh = keyHigh;
+	}
+
+	inline const std::optional<ObjectUIDType>& getRightSibling()
+	{
+		return m_ptrData->m_uidRightSibling;
+	}
+
+	inline void setRightSibling(const std::optional<ObjectUIDType>& uidSibling)
+	{
+		m_ptrData->m_uidRightSibling = uidSibling;
+	}
+#endif __BLINK_TREE__
+
 	inline bool canTriggerSplit(size_t nDegree)
 	{
 		return m_ptrData->m_vtPivots.size() + 1 > nDegree;
@@ -368,11 +527,21 @@ public:
 	template <typename Cache>
 	inline ErrorCode split(Cache ptrCache, std::optional<ObjectUIDType>& uidSibling, KeyType& pivotKeyForParent)
 	{
-		size_t nMid = m_ptrData->m_vtPivots.size() / 2;
+		return split<Cache>(ptrCache, uidSibling, pivotKeyForParent, m_ptrData->m_vtPivots.size() / 2);
+	}
 
+	// Hands the pivot at 'nMid' to the parent and moves the pivots and children that follow it to the new sibling.
+	template <typename Cache>
+	inline ErrorCode split(Cache ptrCache, std::optional<ObjectUIDType>& uidSibling, KeyType& pivotKeyForParent, size_t nMid)
+	{
 		ptrCache->template createObjectOfType<SelfType>(uidSibling,
 			m_ptrData->m_vtPivots.begin() + nMid + 1, m_ptrData->m_vtPivots.end(),
+#ifdef __BLINK_TREE__
+			m_ptrData->m_vtChildren.begin() + nMid + 1, m_ptrData->m_vtChildren.end(),
+			m_ptrData->m_keyHigh, m_ptrData->m_uidRightSibling);
+#else __BLINK_TREE__
 			m_ptrData->m_vtChildren.begin() + nMid + 1, m_ptrData->m_vtChildren.end());
+#endif __BLINK_TREE__
 
 		if (!uidSibling)
 		{
@@ -381,6 +550,11 @@ public:
 
 		pivotKeyForParent = m_ptrData->m_vtPivots[nMid];
 
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = pivotKeyForParent;
+		m_ptrData->m_uidRightSibling = uidSibling;
+#endif __BLINK_TREE__
+
 		m_ptrData->m_vtPivots.resize(nMid);
 		m_ptrData->m_vtChildren.resize(nMid + 1);
 
@@ -404,6 +578,10 @@ public:
 		m_ptrData->m_vtChildren.insert(m_ptrData->m_vtChildren.begin(), value);
 
 		pivotKeyForParent = key;
+
+#ifdef __BLINK_TREE__
+		ptrLHSSibling->m_ptrData->m_keyHigh = pivotKeyForParent;
+#endif __BLINK_TREE__
 	}
 
 	inline void moveAnEntityFromRHSSibling(shared_ptr<SelfType> ptrRHSSibling, KeyType& pivotKeyForEntity, KeyType& pivotKeyForParent)
@@ -423,6 +601,10 @@ public:
 		m_ptrData->m_vtChildren.push_back(value);
 
 		pivotKeyForParent = key;// ptrRHSSibling->m_ptrData->m_vtPivots.front();
+
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = pivotKeyForParent;
+#endif __BLINK_TREE__
 	}
 
 	inline void mergeNodes(shared_ptr<SelfType> ptrSibling, KeyType& pivotKey)
@@ -430,6 +612,11 @@ public:
 		m_ptrData->m_vtPivots.push_back(pivotKey);
 		m_ptrData->m_vtPivots.insert(m_ptrData->m_vtPivots.end(), ptrSibling->m_ptrData->m_vtPivots.begin(), ptrSibling->m_ptrData->m_vtPivots.end());
 		m_ptrData->m_vtChildren.insert(m_ptrData->m_vtChildren.end(), ptrSibling->m_ptrData->m_vtChildren.begin(), ptrSibling->m_ptrData->m_vtChildren.end());
+
+#ifdef __BLINK_TREE__
+		m_ptrData->m_keyHigh = ptrSibling->m_ptrData->m_keyHigh;
+		m_ptrData->m_uidRightSibling = ptrSibling->m_ptrData->m_uidRightSibling;
+#endif __BLINK_TREE__
 	}
 
 public:
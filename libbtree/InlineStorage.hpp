@@ -0,0 +1,286 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+
+#define CACHE_LINE_SIZE 64
+
+// A vector that keeps up to N elements in place, in a cache-line-aligned buffer, so that the node that embeds it needs no
+// allocation of its own. A node outgrows its degree only transiently (e.g. until it is split), in which case the elements
+// move to the heap and come back once they fit again. Limited to trivially copyable elements, which are moved with memmove.
+template <typename T, size_t N>
+class InlineVector
+{
+	static_assert(std::is_trivially_copyable<T>::value, "InlineVector is limited to trivially copyable types");
+
+public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+private:
+	alignas(CACHE_LINE_SIZE) unsigned char m_szInline[N * sizeof(T)];
+
+	T* m_ptrHeap;
+	size_t m_nCapacity;
+	size_t m_nSize;
+
+public:
+	~InlineVector()
+	{
+		releaseHeap();
+	}
+
+	InlineVector()
+		: m_ptrHeap(nullptr)
+		, m_nCapacity(N)
+		, m_nSize(0)
+	{
+	}
+
+	InlineVector(const InlineVector& source)
+		: m_ptrHeap(nullptr)
+		, m_nCapacity(N)
+		, m_nSize(0)
+	{
+		assign(source.begin(), source.end());
+	}
+
+	InlineVector& operator=(const InlineVector& source)
+	{
+		if (this != &source)
+		{
+			assign(source.begin(), source.end());
+		}
+
+		return *this;
+	}
+
+	inline size_t size() const { return m_nSize; }
+	inline size_t capacity() const { return m_nCapacity; }
+	inline bool empty() const { return m_nSize == 0; }
+
+	inline T* data() { return m_ptrHeap != nullptr ? m_ptrHeap : reinterpret_cast<T*>(m_szInline); }
+	inline const T* data() const { return m_ptrHeap != nullptr ? m_ptrHeap : reinterpret_cast<const T*>(m_szInline); }
+
+	inline iterator begin() { return data(); }
+	inline iterator end() { return data() + m_nSize; }
+	inline const_iterator begin() const { return data(); }
+	inline const_iterator end() const { return data() + m_nSize; }
+	inline const_iterator cbegin() const { return data(); }
+	inline const_iterator cend() const { return data() + m_nSize; }
+
+	inline T& operator[](size_t nIdx) { return data()[nIdx]; }
+	inline const T& operator[](size_t nIdx) const { return data()[nIdx]; }
+
+	inline T& front() { return data()[0]; }
+	inline const T& front() const { return data()[0]; }
+	inline T& back() { return data()[m_nSize - 1]; }
+	inline const T& back() const { return data()[m_nSize - 1]; }
+
+	inline void reserve(size_t nCapacity)
+	{
+		grow(nCapacity);
+	}
+
+	inline void resize(size_t nSize)
+	{
+		if (nSize > m_nSize)
+		{
+			grow(nSize);
+
+			T* ptrData = data();
+			for (size_t nIdx = m_nSize; nIdx < nSize; nIdx++)
+			{
+				new (ptrData + nIdx) T();
+			}
+		}
+
+		m_nSize = nSize;
+		shrinkToInline();
+	}
+
+	inline void clear()
+	{
+		m_nSize = 0;
+		shrinkToInline();
+	}
+
+	inline void push_back(const T& value)
+	{
+		T _value = value;	// 'value' may live in the buffer that grow replaces.
+
+		grow(m_nSize + 1);
+		data()[m_nSize++] = _value;
+	}
+
+	inline void pop_back()
+	{
+		m_nSize--;
+		shrinkToInline();
+	}
+
+	inline iterator insert(const_iterator itPos, const T& value)
+	{
+		size_t nIdx = itPos - begin();
+		T _value = value;
+
+		grow(m_nSize + 1);
+
+		T* ptrData = data();
+		memmove(ptrData + nIdx + 1, ptrData + nIdx, (m_nSize - nIdx) * sizeof(T));
+		ptrData[nIdx] = _value;
+		m_nSize++;
+
+		return ptrData + nIdx;
+	}
+
+	template <typename InputIterator>
+	inline iterator insert(const_iterator itPos, InputIterator itFirst, InputIterator itLast)
+	{
+		size_t nIdx = itPos - begin();
+		size_t nCount = std::distance(itFirst, itLast);
+
+		grow(m_nSize + nCount);
+
+		T* ptrData = data();
+		memmove(ptrData + nIdx + nCount, ptrData + nIdx, (m_nSize - nIdx) * sizeof(T));
+		std::copy(itFirst, itLast, ptrData + nIdx);
+		m_nSize += nCount;
+
+		return ptrData + nIdx;
+	}
+
+	inline iterator erase(const_iterator itPos)
+	{
+		return erase(itPos, itPos + 1);
+	}
+
+	inline iterator erase(const_iterator itFirst, const_iterator itLast)
+	{
+		size_t nIdx = itFirst - begin();
+		size_t nCount = itLast - itFirst;
+
+		T* ptrData = data();
+		memmove(ptrData + nIdx, ptrData + nIdx + nCount, (m_nSize - nIdx - nCount) * sizeof(T));
+		m_nSize -= nCount;
+
+		shrinkToInline();
+
+		return data() + nIdx;
+	}
+
+	template <typename InputIterator>
+	inline void assign(InputIterator itFirst, InputIterator itLast)
+	{
+		m_nSize = 0;
+		insert(begin(), itFirst, itLast);
+		shrinkToInline();
+	}
+
+	inline void swap(InlineVector& other)
+	{
+		InlineVector _other(std::move(other));
+		other = std::move(*this);
+		*this = std::move(_other);
+	}
+
+	InlineVector(InlineVector&& source) noexcept
+		: m_ptrHeap(nullptr)
+		, m_nCapacity(N)
+		, m_nSize(0)
+	{
+		*this = std::move(source);
+	}
+
+	InlineVector& operator=(InlineVector&& source) noexcept
+	{
+		if (this == &source)
+		{
+			return *this;
+		}
+
+		releaseHeap();
+
+		if (source.m_ptrHeap != nullptr)
+		{
+			m_ptrHeap = source.m_ptrHeap;
+			m_nCapacity = source.m_nCapacity;
+		}
+		else
+		{
+			memcpy(m_szInline, source.m_szInline, source.m_nSize * sizeof(T));
+		}
+
+		m_nSize = source.m_nSize;
+
+		source.m_ptrHeap = nullptr;
+		source.m_nCapacity = N;
+		source.m_nSize = 0;
+
+		return *this;
+	}
+
+private:
+	inline void grow(size_t nCapacity)
+	{
+		if (nCapacity <= m_nCapacity)
+		{
+			return;
+		}
+
+		nCapacity = std::max(nCapacity, 2 * m_nCapacity);
+
+		T* ptrHeap = static_cast<T*>(::operator new(nCapacity * sizeof(T), std::align_val_t(CACHE_LINE_SIZE)));
+		memcpy(ptrHeap, data(), m_nSize * sizeof(T));
+
+		releaseHeap();
+
+		m_ptrHeap = ptrHeap;
+		m_nCapacity = nCapacity;
+	}
+
+	inline void shrinkToInline()
+	{
+		if (m_ptrHeap == nullptr || m_nSize > N)
+		{
+			return;
+		}
+
+		memcpy(m_szInline, m_ptrHeap, m_nSize * sizeof(T));
+
+		releaseHeap();
+	}
+
+	inline void releaseHeap()
+	{
+		if (m_ptrHeap != nullptr)
+		{
+			::operator delete(m_ptrHeap, std::align_val_t(CACHE_LINE_SIZE));
+
+			m_ptrHeap = nullptr;
+			m_nCapacity = N;
+		}
+	}
+};
+
+// Holds a T in place behind the interface of the shared_ptr it stands in for, so that a node can embed its data struct
+// instead of allocating it separately without changing how the node accesses it.
+template <typename T>
+class InlinePtr
+{
+private:
+	T m_data;
+
+public:
+	inline T* operator->() { return &m_data; }
+	inline const T* operator->() const { return &m_data; }
+	inline T& operator*() { return m_data; }
+	inline const T& operator*() const { return m_data; }
+	inline T* get() { return &m_data; }
+
+	// The data is owned by the node itself.
+	inline void reset() {}
+};
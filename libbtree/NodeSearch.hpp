@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define __NODE_SEARCH_SIMD__
+#endif
+
+// Search kernels over the sorted key array of a node, selected at compile time by the key type:
+// - 32/64-bit integers: arrays of up to LINEAR_SEARCH_LIMIT keys are searched by counting the keys that precede the probe
+//   with AVX2/SSE compares, longer ones (or all, without a vector unit for the key width) by a branchless binary search.
+// - other arithmetic types: branchless binary search.
+// - anything else: std::lower_bound/std::upper_bound.
+// The limits are where the binary search catches up with the vectorized count in node_search_test (sandbox).
+template <typename KeyType>
+class NodeSearch
+{
+public:
+#if defined(__AVX2__)
+	static const size_t LINEAR_SEARCH_LIMIT = 128 / sizeof(KeyType);
+#elif defined(__NODE_SEARCH_SIMD__)
+	static const size_t LINEAR_SEARCH_LIMIT = sizeof(KeyType) == 4 ? 8 : 0;
+#else
+	static const size_t LINEAR_SEARCH_LIMIT = 0;
+#endif
+
+	static constexpr bool IS_VECTORIZABLE = std::is_integral_v<KeyType> && !std::is_same_v<KeyType, bool>
+		&& (sizeof(KeyType) == 4 || sizeof(KeyType) == 8);
+
+public:
+	// Index of the first key not less than 'key'.
+	static inline size_t lowerBound(const KeyType* ptrKeys, size_t nCount, const KeyType& key)
+	{
+		return search<false>(ptrKeys, nCount, key);
+	}
+
+	// Index of the first key greater than 'key'.
+	static inline size_t upperBound(const KeyType* ptrKeys, size_t nCount, const KeyType& key)
+	{
+		return search<true>(ptrKeys, nCount, key);
+	}
+
+	// Number of keys less than (or, with 'bInclusive', not greater than) 'key'; as the keys are sorted, it is the position
+	// lower_bound (upper_bound) would return.
+	template <bool bInclusive>
+	static inline size_t linearSearch(const KeyType* ptrKeys, size_t nCount, const KeyType& key)
+	{
+		size_t nIdx = 0, nPreceding = 0;
+
+#ifdef __NODE_SEARCH_SIMD__
+		if constexpr (IS_VECTORIZABLE)
+		{
+			// A compare yields -1 in the lanes that match, which are summed up across the iterations and reduced only once
+			// at the end. The compares are signed, hence unsigned keys are biased into the signed range first.
+			if constexpr (sizeof(KeyType) == 4)
+			{
+				const int32_t nBias = std::is_signed_v<KeyType> ? 0 : INT32_MIN;
+#ifdef __AVX2__
+				const __m256i vBias = _mm256_set1_epi32(nBias);
+				const __m256i vKey = _mm256_xor_si256(_mm256_set1_epi32((int32_t)key), vBias);
+
+				__m256i vHits = _mm256_setzero_si256();
+				for (; nIdx + 8 <= nCount; nIdx += 8)
+				{
+					__m256i vKeys = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptrKeys + nIdx)), vBias);
+					vHits = _mm256_sub_epi32(vHits, bInclusive ? _mm256_cmpgt_epi32(vKeys, vKey) : _mm256_cmpgt_epi32(vKey, vKeys));
+				}
+
+				__m128i vHits128 = _mm_add_epi32(_mm256_castsi256_si128(vHits), _mm256_extracti128_si256(vHits, 1));
+#else // !__AVX2__
+				__m128i vHits128 = _mm_setzero_si128();
+#endif __AVX2__
+				const __m128i vBias128 = _mm_set1_epi32(nBias);
+				const __m128i vKey128 = _mm_xor_si128(_mm_set1_epi32((int32_t)key), vBias128);
+
+				for (; nIdx + 4 <= nCount; nIdx += 4)
+				{
+					__m128i vKeys = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptrKeys + nIdx)), vBias128);
+					vHits128 = _mm_sub_epi32(vHits128, bInclusive ? _mm_cmpgt_epi32(vKeys, vKey128) : _mm_cmpgt_epi32(vKey128, vKeys));
+				}
+
+				vHits128 = _mm_add_epi32(vHits128, _mm_shuffle_epi32(vHits128, _MM_SHUFFLE(1, 0, 3, 2)));
+				vHits128 = _mm_add_epi32(vHits128, _mm_shuffle_epi32(vHits128, _MM_SHUFFLE(2, 3, 0, 1)));
+
+				size_t nHits = (uint32_t)_mm_cvtsi128_si32(vHits128);
+				nPreceding = bInclusive ? nIdx - nHits : nHits;
+			}
+			else
+			{
+#ifdef __AVX2__
+				const __m256i vBias = _mm256_set1_epi64x(std::is_signed_v<KeyType> ? 0 : INT64_MIN);
+				const __m256i vKey = _mm256_xor_si256(_mm256_set1_epi64x((int64_t)key), vBias);
+
+				__m256i vHits = _mm256_setzero_si256();
+				for (; nIdx + 4 <= nCount; nIdx += 4)
+				{
+					__m256i vKeys = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptrKeys + nIdx)), vBias);
+					vHits = _mm256_sub_epi64(vHits, bInclusive ? _mm256_cmpgt_epi64(vKeys, vKey) : _mm256_cmpgt_epi64(vKey, vKeys));
+				}
+
+				__m128i vHits128 = _mm_add_epi64(_mm256_castsi256_si128(vHits), _mm256_extracti128_si256(vHits, 1));
+				vHits128 = _mm_add_epi64(vHits128, _mm_unpackhi_epi64(vHits128, vHits128));
+
+				size_t nHits = (uint64_t)_mm_cvtsi128_si64(vHits128);
+				nPreceding = bInclusive ? nIdx - nHits : nHits;
+#endif __AVX2__
+			}
+		}
+#endif __NODE_SEARCH_SIMD__
+
+		for (; nIdx < nCount; nIdx++)
+		{
+			nPreceding += bInclusive ? !(key < ptrKeys[nIdx]) : (ptrKeys[nIdx] < key);
+		}
+
+		return nPreceding;
+	}
+
+	// Halves the range without a data-dependent branch, so that the compiler can use conditional moves.
+	template <bool bInclusive>
+	static inline size_t binarySearch(const KeyType* ptrKeys, size_t nCount, const KeyType& key)
+	{
+		if (nCount == 0)
+		{
+			return 0;
+		}
+
+		const KeyType* ptrBase = ptrKeys;
+		while (nCount > 1)
+		{
+			size_t nHalf = nCount / 2;
+			ptrBase = (bInclusive ? !(key < ptrBase[nHalf]) : (ptrBase[nHalf] < key)) ? ptrBase + nHalf : ptrBase;
+			nCount -= nHalf;
+		}
+
+		return (ptrBase - ptrKeys) + (bInclusive ? !(key < *ptrBase) : (*ptrBase < key));
+	}
+
+private:
+	template <bool bInclusive>
+	static inline size_t search(const KeyType* ptrKeys, size_t nCount, const KeyType& key)
+	{
+		if constexpr (IS_VECTORIZABLE)
+		{
+			if (nCount <= LINEAR_SEARCH_LIMIT)
+			{
+				return linearSearch<bInclusive>(ptrKeys, nCount, key);
+			}
+
+			return binarySearch<bInclusive>(ptrKeys, nCount, key);
+		}
+		else if constexpr (std::is_arithmetic_v<KeyType>)
+		{
+			return binarySearch<bInclusive>(ptrKeys, nCount, key);
+		}
+		else if constexpr (bInclusive)
+		{
+			return std::upper_bound(ptrKeys, ptrKeys + nCount, key) - ptrKeys;
+		}
+		else
+		{
+			return std::lower_bound(ptrKeys, ptrKeys + nCount, key) - ptrKeys;
+		}
+	}
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+// Hints the hardware to pull the cache line at 'ptr' in ahead of a read.
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#define PREFETCH(ptr) _mm_prefetch(reinterpret_cast<const char*>(ptr), _MM_HINT_T0)
+#else
+#define PREFETCH(ptr) __builtin_prefetch(ptr, 0, 3)
+#endif
@@ -0,0 +1,916 @@
+#pragma once
+#include <memory>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <functional>
+
+// Replacement policies for LRUCache. A policy orders the resident items and picks the ones to evict; the cache owns the
+// directory, the items and the locking, and calls into the policy under its exclusive lock only. The items are expected to
+// provide m_uidSelf, m_ptrPrev/m_ptrNext (the policy's lists are intrusive, with plain pointers), m_nQueue (0 while not in
+// any list) and m_nFrequency.
+//
+// New items come in through 'add' when the tree creates them and through 'admit' when they are loaded from the storage;
+// only an admission policy tells the two apart.
+//
+// Eviction is asynchronous: 'victim' detaches an item, and the flush either gives it back with 'restore' (when the tree
+// cannot write it yet) or reports it with 'evicted' once its uid on the storage is known, which is the uid that the ghost
+// lists remember since it is the one the item is loaded back under.
+
+template <typename ItemType>
+class ItemList
+{
+public:
+	ItemType* m_ptrHead;
+	ItemType* m_ptrTail;
+	size_t m_nSize;
+
+	ItemList()
+		: m_ptrHead(nullptr)
+		, m_ptrTail(nullptr)
+		, m_nSize(0)
+	{
+	}
+
+	~ItemList()
+	{
+		clear();
+	}
+
+	inline void pushFront(ItemType* ptrItem)
+	{
+		ptrItem->m_ptrPrev = nullptr;
+		ptrItem->m_ptrNext = m_ptrHead;
+
+		if (m_ptrHead)
+		{
+			m_ptrHead->m_ptrPrev = ptrItem;
+		}
+		else
+		{
+			m_ptrTail = ptrItem;
+		}
+
+		m_ptrHead = ptrItem;
+		m_nSize++;
+	}
+
+	inline void pushBack(ItemType* ptrItem)
+	{
+		ptrItem->m_ptrNext = nullptr;
+		ptrItem->m_ptrPrev = m_ptrTail;
+
+		if (m_ptrTail)
+		{
+			m_ptrTail->m_ptrNext = ptrItem;
+		}
+		else
+		{
+			m_ptrHead = ptrItem;
+		}
+
+		m_ptrTail = ptrItem;
+		m_nSize++;
+	}
+
+	inline void remove(ItemType* ptrItem)
+	{
+		if (ptrItem->m_ptrPrev)
+		{
+			ptrItem->m_ptrPrev->m_ptrNext = ptrItem->m_ptrNext;
+		}
+		else
+		{
+			m_ptrHead = ptrItem->m_ptrNext;
+		}
+
+		if (ptrItem->m_ptrNext)
+		{
+			ptrItem->m_ptrNext->m_ptrPrev = ptrItem->m_ptrPrev;
+		}
+		else
+		{
+			m_ptrTail = ptrItem->m_ptrPrev;
+		}
+
+		ptrItem->m_ptrPrev = nullptr;
+		ptrItem->m_ptrNext = nullptr;
+		m_nSize--;
+	}
+
+	inline void moveToFront(ItemType* ptrItem)
+	{
+		if (ptrItem == m_ptrHead)
+		{
+			return;
+		}
+
+		remove(ptrItem);
+		pushFront(ptrItem);
+	}
+
+	// The item nearest to the tail that 'fnEvictable' accepts.
+	template <typename Evictable>
+	inline ItemType* findFromTail(Evictable& fnEvictable)
+	{
+		ItemType* ptrItem = m_ptrTail;
+		while (ptrItem != nullptr && !fnEvictable(ptrItem))
+		{
+			ptrItem = ptrItem->m_ptrPrev;
+		}
+
+		return ptrItem;
+	}
+
+	// The items belong to the cache (see ItemPool.hpp); only their links are cut.
+	void clear()
+	{
+		while (m_ptrHead != nullptr)
+		{
+			ItemType* ptrNext = m_ptrHead->m_ptrNext;
+			m_ptrHead->m_ptrPrev = nullptr;
+			m_ptrHead->m_ptrNext = nullptr;
+			m_ptrHead = ptrNext;
+		}
+
+		m_ptrTail = nullptr;
+		m_nSize = 0;
+	}
+};
+
+// A bounded FIFO of the uids of evicted items.
+template <typename ObjectUIDType>
+class GhostList
+{
+	std::list<ObjectUIDType> m_lsUIDs;
+	std::unordered_map<ObjectUIDType, typename std::list<ObjectUIDType>::iterator> m_mpUIDs;
+
+public:
+	inline void push(const ObjectUIDType& uid)
+	{
+		if (m_mpUIDs.find(uid) != m_mpUIDs.end())
+		{
+			return;
+		}
+
+		m_lsUIDs.push_front(uid);
+		m_mpUIDs[uid] = m_lsUIDs.begin();
+	}
+
+	inline bool erase(const ObjectUIDType& uid)
+	{
+		auto it = m_mpUIDs.find(uid);
+		if (it == m_mpUIDs.end())
+		{
+			return false;
+		}
+
+		m_lsUIDs.erase((*it).second);
+		m_mpUIDs.erase(it);
+		return true;
+	}
+
+	inline void popBack()
+	{
+		m_mpUIDs.erase(m_lsUIDs.back());
+		m_lsUIDs.pop_back();
+	}
+
+	inline void trim(size_t nSize)
+	{
+		while (m_lsUIDs.size() > nSize)
+		{
+			popBack();
+		}
+	}
+
+	inline size_t size() const
+	{
+		return m_lsUIDs.size();
+	}
+};
+
+// Plain LRU. The eviction stops at the first tail item that is in use, since each operation moves the nodes it accessed
+// to the front and the items preceding it would thus be in use as well.
+template <typename ItemType>
+class LRUPolicy
+{
+	static constexpr uint8_t QUEUE = 1;
+
+	ItemList<ItemType> m_lsItems;
+
+public:
+	LRUPolicy(size_t nCapacity)
+	{
+	}
+
+	inline void add(ItemType* ptrItem)
+	{
+		ptrItem->m_nQueue = QUEUE;
+		m_lsItems.pushFront(ptrItem);
+	}
+
+	inline void admit(ItemType* ptrItem)
+	{
+		add(ptrItem);
+	}
+
+	inline void touch(ItemType* ptrItem)
+	{
+		m_lsItems.moveToFront(ptrItem);
+	}
+
+	inline void remove(ItemType* ptrItem)
+	{
+		m_lsItems.remove(ptrItem);
+		ptrItem->m_nQueue = 0;
+	}
+
+	template <typename Evictable>
+	inline ItemType* victim(Evictable fnEvictable)
+	{
+		ItemType* ptrItem = m_lsItems.m_ptrTail;
+		if (ptrItem == nullptr || !fnEvictable(ptrItem))
+		{
+			return nullptr;
+		}
+
+		m_lsItems.remove(ptrItem);
+		return ptrItem;
+	}
+
+	inline void restore(ItemType* ptrItem)
+	{
+		m_lsItems.pushFront(ptrItem);
+	}
+
+	inline void evicted(ItemType* ptrItem, const decltype(ItemType::m_uidSelf)& uidStored)
+	{
+		ptrItem->m_nQueue = 0;
+	}
+
+	inline size_t size() const
+	{
+		return m_lsItems.m_nSize;
+	}
+
+	inline void clear()
+	{
+		m_lsItems.clear();
+	}
+};
+
+// 2Q (Johnson and Shasha). New items enter the A1in FIFO, whose hits are not counted, and the uids of the ones it evicts
+// are remembered in A1out; only an item that is loaded again while in A1out is admitted to the Am LRU. A scan thus
+// cycles through A1in without displacing the nodes in Am.
+template <typename ItemType>
+class TwoQPolicy
+{
+	typedef decltype(ItemType::m_uidSelf) ObjectUIDType;
+
+	static constexpr uint8_t QUEUE_A1IN = 1;
+	static constexpr uint8_t QUEUE_AM = 2;
+
+	ItemList<ItemType> m_lsA1in;
+	ItemList<ItemType> m_lsAm;
+	GhostList<ObjectUIDType> m_lsA1out;
+
+	size_t m_nKin;
+	size_t m_nKout;
+
+public:
+	TwoQPolicy(size_t nCapacity)
+		: m_nKin(std::max<size_t>(nCapacity / 4, 1))
+		, m_nKout(std::max<size_t>(nCapacity / 2, 1))
+	{
+	}
+
+	inline void add(ItemType* ptrItem)
+	{
+		if (m_lsA1out.erase(ptrItem->m_uidSelf))
+		{
+			ptrItem->m_nQueue = QUEUE_AM;
+			m_lsAm.pushFront(ptrItem);
+		}
+		else
+		{
+			ptrItem->m_nQueue = QUEUE_A1IN;
+			m_lsA1in.pushFront(ptrItem);
+		}
+	}
+
+	inline void admit(ItemType* ptrItem)
+	{
+		add(ptrItem);
+	}
+
+	inline void touch(ItemType* ptrItem)
+	{
+		if (ptrItem->m_nQueue == QUEUE_AM)
+		{
+			m_lsAm.moveToFront(ptrItem);
+		}
+	}
+
+	inline void remove(ItemType* ptrItem)
+	{
+		getList(ptrItem->m_nQueue).remove(ptrItem);
+		ptrItem->m_nQueue = 0;
+	}
+
+	template <typename Evictable>
+	inline ItemType* victim(Evictable fnEvictable)
+	{
+		ItemList<ItemType>* vtLists[2] = { &m_lsAm, &m_lsA1in };
+		if (m_lsA1in.m_nSize > m_nKin)
+		{
+			std::swap(vtLists[0], vtLists[1]);
+		}
+
+		for (ItemList<ItemType>* ptrList : vtLists)
+		{
+			ItemType* ptrItem = ptrList->findFromTail(fnEvictable);
+			if (ptrItem != nullptr)
+			{
+				ptrList->remove(ptrItem);
+				return ptrItem;
+			}
+		}
+
+		return nullptr;
+	}
+
+	inline void restore(ItemType* ptrItem)
+	{
+		getList(ptrItem->m_nQueue).pushFront(ptrItem);
+	}
+
+	inline void evicted(ItemType* ptrItem, const ObjectUIDType& uidStored)
+	{
+		if (ptrItem->m_nQueue == QUEUE_A1IN)
+		{
+			m_lsA1out.push(uidStored);
+			m_lsA1out.trim(m_nKout);
+		}
+
+		ptrItem->m_nQueue = 0;
+	}
+
+	inline size_t size() const
+	{
+		return m_lsA1in.m_nSize + m_lsAm.m_nSize;
+	}
+
+	inline void clear()
+	{
+		m_lsA1in.clear();
+		m_lsAm.clear();
+	}
+
+private:
+	inline ItemList<ItemType>& getList(uint8_t nQueue)
+	{
+		return nQueue == QUEUE_AM ? m_lsAm : m_lsA1in;
+	}
+};
+
+// ARC (Megiddo and Modha). T1 holds the items seen once and T2 the ones seen again; B1 and B2 remember what each of them
+// evicted, and a load that hits either ghost list shifts the target size of T1 towards the list that would have kept it.
+template <typename ItemType>
+class ARCPolicy
+{
+	typedef decltype(ItemType::m_uidSelf) ObjectUIDType;
+
+	static constexpr uint8_t QUEUE_T1 = 1;
+	static constexpr uint8_t QUEUE_T2 = 2;
+
+	ItemList<ItemType> m_lsT1;
+	ItemList<ItemType> m_lsT2;
+	GhostList<ObjectUIDType> m_lsB1;
+	GhostList<ObjectUIDType> m_lsB2;
+
+	size_t m_nCapacity;
+	size_t m_nTarget;
+
+public:
+	ARCPolicy(size_t nCapacity)
+		: m_nCapacity(std::max<size_t>(nCapacity, 1))
+		, m_nTarget(0)
+	{
+	}
+
+	inline void add(ItemType* ptrItem)
+	{
+		size_t nB1 = m_lsB1.size();
+		size_t nB2 = m_lsB2.size();
+
+		if (m_lsB1.erase(ptrItem->m_uidSelf))
+		{
+			m_nTarget = std::min(m_nCapacity, m_nTarget + std::max<size_t>(nB2 / nB1, 1));
+
+			ptrItem->m_nQueue = QUEUE_T2;
+			m_lsT2.pushFront(ptrItem);
+		}
+		else if (m_lsB2.erase(ptrItem->m_uidSelf))
+		{
+			m_nTarget -= std::min(m_nTarget, std::max<size_t>(nB1 / nB2, 1));
+
+			ptrItem->m_nQueue = QUEUE_T2;
+			m_lsT2.pushFront(ptrItem);
+		}
+		else
+		{
+			ptrItem->m_nQueue = QUEUE_T1;
+			m_lsT1.pushFront(ptrItem);
+		}
+	}
+
+	inline void admit(ItemType* ptrItem)
+	{
+		add(ptrItem);
+	}
+
+	inline void touch(ItemType* ptrItem)
+	{
+		getList(ptrItem->m_nQueue).remove(ptrItem);
+
+		ptrItem->m_nQueue = QUEUE_T2;
+		m_lsT2.pushFront(ptrItem);
+	}
+
+	inline void remove(ItemType* ptrItem)
+	{
+		getList(ptrItem->m_nQueue).remove(ptrItem);
+		ptrItem->m_nQueue = 0;
+	}
+
+	template <typename Evictable>
+	inline ItemType* victim(Evictable fnEvictable)
+	{
+		ItemList<ItemType>* vtLists[2] = { &m_lsT2, &m_lsT1 };
+		if (m_lsT1.m_nSize > 0 && (m_lsT1.m_nSize > m_nTarget || m_lsT2.m_nSize == 0))
+		{
+			std::swap(vtLists[0], vtLists[1]);
+		}
+
+		for (ItemList<ItemType>* ptrList : vtLists)
+		{
+			ItemType* ptrItem = ptrList->findFromTail(fnEvictable);
+			if (ptrItem != nullptr)
+			{
+				ptrList->remove(ptrItem);
+				return ptrItem;
+			}
+		}
+
+		return nullptr;
+	}
+
+	inline void restore(ItemType* ptrItem)
+	{
+		getList(ptrItem->m_nQueue).pushFront(ptrItem);
+	}
+
+	inline void evicted(ItemType* ptrItem, const ObjectUIDType& uidStored)
+	{
+		if (ptrItem->m_nQueue == QUEUE_T1)
+		{
+			m_lsB1.push(uidStored);
+		}
+		else
+		{
+			m_lsB2.push(uidStored);
+		}
+
+		ptrItem->m_nQueue = 0;
+
+		// |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c.
+		m_lsB1.trim(m_nCapacity - std::min(m_nCapacity, m_lsT1.m_nSize));
+		m_lsB2.trim(2 * m_nCapacity - std::min(2 * m_nCapacity, m_lsT1.m_nSize + m_lsT2.m_nSize + m_lsB1.size()));
+	}
+
+	inline size_t size() const
+	{
+		return m_lsT1.m_nSize + m_lsT2.m_nSize;
+	}
+
+	inline void clear()
+	{
+		m_lsT1.clear();
+		m_lsT2.clear();
+	}
+
+private:
+	inline ItemList<ItemType>& getList(uint8_t nQueue)
+	{
+		return nQueue == QUEUE_T2 ? m_lsT2 : m_lsT1;
+	}
+};
+
+// S3-FIFO (Yang et al.). New items enter a small FIFO S (a tenth of the capacity); the ones that are hit while there move
+// on to the main FIFO M when they reach its tail, and the others are evicted and remembered in the ghost FIFO G, whose
+// hits are loaded straight into M. M reinserts the items hit since they last passed its tail. Hits only bump a counter.
+template <typename ItemType>
+class S3FIFOPolicy
+{
+	typedef decltype(ItemType::m_uidSelf) ObjectUIDType;
+
+	static constexpr uint8_t QUEUE_S = 1;
+	static constexpr uint8_t QUEUE_M = 2;
+
+	static constexpr uint8_t MAX_FREQUENCY = 3;
+
+	ItemList<ItemType> m_lsS;
+	ItemList<ItemType> m_lsM;
+	GhostList<ObjectUIDType> m_lsG;
+
+	size_t m_nCapacity;
+	size_t m_nSmall;
+
+public:
+	S3FIFOPolicy(size_t nCapacity)
+		: m_nCapacity(std::max<size_t>(nCapacity, 1))
+		, m_nSmall(std::max<size_t>(nCapacity / 10, 1))
+	{
+	}
+
+	inline void add(ItemType* ptrItem)
+	{
+		ptrItem->m_nFrequency = 0;
+
+		if (m_lsG.erase(ptrItem->m_uidSelf))
+		{
+			ptrItem->m_nQueue = QUEUE_M;
+			m_lsM.pushFront(ptrItem);
+		}
+		else
+		{
+			ptrItem->m_nQueue = QUEUE_S;
+			m_lsS.pushFront(ptrItem);
+		}
+	}
+
+	inline void admit(ItemType* ptrItem)
+	{
+		add(ptrItem);
+	}
+
+	inline void touch(ItemType* ptrItem)
+	{
+		if (ptrItem->m_nFrequency < MAX_FREQUENCY)
+		{
+			ptrItem->m_nFrequency++;
+		}
+	}
+
+	inline void remove(ItemType* ptrItem)
+	{
+		getList(ptrItem->m_nQueue).remove(ptrItem);
+		ptrItem->m_nQueue = 0;
+	}
+
+	// An item in use is moved back to the head of its queue, like one that has been hit; the number of steps is bounded by
+	// the frequencies the items can have, so that a round in which everything is in use ends.
+	template <typename Evictable>
+	inline ItemType* victim(Evictable fnEvictable)
+	{
+		size_t nSteps = m_lsS.m_nSize + (MAX_FREQUENCY + 1) * (m_lsS.m_nSize + m_lsM.m_nSize);
+
+		while (nSteps-- > 0)
+		{
+			if (m_lsS.m_nSize > 0 && (m_lsS.m_nSize > m_nSmall || m_lsM.m_nSize == 0))
+			{
+				ItemType* ptrItem = m_lsS.m_ptrTail;
+				m_lsS.remove(ptrItem);
+
+				if (ptrItem->m_nFrequency > 0)
+				{
+					ptrItem->m_nFrequency = 0;
+					ptrItem->m_nQueue = QUEUE_M;
+					m_lsM.pushFront(ptrItem);
+					continue;
+				}
+
+				if (!fnEvictable(ptrItem))
+				{
+					m_lsS.pushFront(ptrItem);
+					continue;
+				}
+
+				return ptrItem;
+			}
+			else if (m_lsM.m_nSize > 0)
+			{
+				ItemType* ptrItem = m_lsM.m_ptrTail;
+				m_lsM.remove(ptrItem);
+
+				if (ptrItem->m_nFrequency > 0)
+				{
+					ptrItem->m_nFrequency--;
+					m_lsM.pushFront(ptrItem);
+					continue;
+				}
+
+				if (!fnEvictable(ptrItem))
+				{
+					m_lsM.pushFront(ptrItem);
+					continue;
+				}
+
+				return ptrItem;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		return nullptr;
+	}
+
+	inline void restore(ItemType* ptrItem)
+	{
+		getList(ptrItem->m_nQueue).pushFront(ptrItem);
+	}
+
+	inline void evicted(ItemType* ptrItem, const ObjectUIDType& uidStored)
+	{
+		if (ptrItem->m_nQueue == QUEUE_S)
+		{
+			m_lsG.push(uidStored);
+			m_lsG.trim(m_nCapacity);
+		}
+
+		ptrItem->m_nQueue = 0;
+	}
+
+	inline size_t size() const
+	{
+		return m_lsS.m_nSize + m_lsM.m_nSize;
+	}
+
+	inline void clear()
+	{
+		m_lsS.clear();
+		m_lsM.clear();
+	}
+
+private:
+	inline ItemList<ItemType>& getList(uint8_t nQueue)
+	{
+		return nQueue == QUEUE_M ? m_lsM : m_lsS;
+	}
+};
+
+// A count-min sketch of 4-bit counters (kept in bytes) behind a doorkeeper bitset: the first occurrence of a key only sets
+// its doorkeeper bits, so that the keys seen once do not take up the counters. Once the sample size is reached all the
+// counters are halved and the doorkeeper is cleared, which lets the estimates follow a changing workload.
+template <typename KeyType>
+class FrequencySketch
+{
+	static constexpr size_t DEPTH = 4;
+	static constexpr uint8_t MAX_COUNT = 15;
+
+	std::vector<uint8_t> m_vtCounters;
+	std::vector<uint64_t> m_vtDoorkeeper;
+
+	size_t m_nMask;
+	size_t m_nDoorkeeperMask;
+	size_t m_nSampleSize;
+	size_t m_nSamples;
+
+public:
+	FrequencySketch(size_t nCapacity)
+		: m_nSamples(0)
+	{
+		// Four counters per row and resident item keep the noise of the other keys well below the counts of the hot ones
+		// over a sample, and the doorkeeper has 16 bits per counter column.
+		size_t nWidth = 16;
+		while (nWidth < 4 * nCapacity)
+		{
+			nWidth <<= 1;
+		}
+
+		m_vtCounters.resize(DEPTH * nWidth, 0);
+		m_vtDoorkeeper.resize(nWidth / 4, 0);
+
+		m_nMask = nWidth - 1;
+		m_nDoorkeeperMask = nWidth * 16 - 1;
+		m_nSampleSize = 10 * std::max<size_t>(nCapacity, 1);
+	}
+
+	inline void record(const KeyType& key)
+	{
+		size_t nHash = hash(key);
+
+		if (setDoorkeeper(nHash))
+		{
+			incrementCounters(nHash, 1);
+		}
+
+		if (++m_nSamples >= m_nSampleSize)
+		{
+			age();
+		}
+	}
+
+	// Adds 'nCount' occurrences to the estimate of 'key' at once, without counting them as samples.
+	inline void increment(const KeyType& key, size_t nCount)
+	{
+		if (nCount == 0)
+		{
+			return;
+		}
+
+		size_t nHash = hash(key);
+
+		if (!setDoorkeeper(nHash))
+		{
+			nCount--;
+		}
+
+		incrementCounters(nHash, nCount);
+	}
+
+	inline size_t estimate(const KeyType& key) const
+	{
+		size_t nHash = hash(key);
+
+		uint8_t nMin = MAX_COUNT;
+		for (size_t nRow = 0; nRow < DEPTH; nRow++)
+		{
+			nMin = std::min(nMin, m_vtCounters[index(nHash, nRow)]);
+		}
+
+		return nMin + (testDoorkeeper(nHash) ? 1 : 0);
+	}
+
+private:
+	// std::hash is the identity for integers on most implementations, hence the splitmix64 finalizer.
+	static inline size_t hash(const KeyType& key)
+	{
+		uint64_t nHash = std::hash<KeyType>()(key);
+		nHash = (nHash ^ (nHash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		nHash = (nHash ^ (nHash >> 27)) * 0x94d049bb133111ebULL;
+		return nHash ^ (nHash >> 31);
+	}
+
+	// Double hashing: row i uses h1 + i * h2.
+	inline size_t index(size_t nHash, size_t nRow) const
+	{
+		size_t nH1 = nHash & 0xffffffff;
+		size_t nH2 = (nHash >> 32) | 1;
+		return nRow * (m_nMask + 1) + ((nH1 + nRow * nH2) & m_nMask);
+	}
+
+	inline bool testDoorkeeper(size_t nHash) const
+	{
+		for (size_t nProbe = 0; nProbe < 2; nProbe++)
+		{
+			size_t nBit = (nHash >> (nProbe * 32)) & m_nDoorkeeperMask;
+			if ((m_vtDoorkeeper[nBit >> 6] & (1ULL << (nBit & 63))) == 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Returns whether the key was already there.
+	inline bool setDoorkeeper(size_t nHash)
+	{
+		bool bPresent = true;
+		for (size_t nProbe = 0; nProbe < 2; nProbe++)
+		{
+			size_t nBit = (nHash >> (nProbe * 32)) & m_nDoorkeeperMask;
+			uint64_t nFlag = 1ULL << (nBit & 63);
+			if ((m_vtDoorkeeper[nBit >> 6] & nFlag) == 0)
+			{
+				m_vtDoorkeeper[nBit >> 6] |= nFlag;
+				bPresent = false;
+			}
+		}
+
+		return bPresent;
+	}
+
+	inline void incrementCounters(size_t nHash, size_t nCount)
+	{
+		for (size_t nRow = 0; nRow < DEPTH; nRow++)
+		{
+			uint8_t& nCounter = m_vtCounters[index(nHash, nRow)];
+			nCounter = (uint8_t)std::min<size_t>(nCounter + nCount, MAX_COUNT);
+		}
+	}
+
+	inline void age()
+	{
+		for (uint8_t& nCounter : m_vtCounters)
+		{
+			nCounter >>= 1;
+		}
+
+		std::fill(m_vtDoorkeeper.begin(), m_vtDoorkeeper.end(), 0);
+		m_nSamples /= 2;
+	}
+};
+
+// TinyLFU (Einziger et al.) in front of an LRU. A loaded item is admitted to the head of the list only when its estimated
+// frequency beats that of the item at the tail, which is the one it would displace; otherwise it is queued at the tail so
+// that it is the next one evicted. The tree needs the loaded node resident while it uses it, hence it cannot be refused.
+template <typename ItemType>
+class TinyLFUPolicy
+{
+	typedef decltype(ItemType::m_uidSelf) ObjectUIDType;
+
+	static constexpr uint8_t QUEUE = 1;
+
+	ItemList<ItemType> m_lsItems;
+	FrequencySketch<ObjectUIDType> m_oSketch;
+
+	size_t m_nCapacity;
+
+public:
+	TinyLFUPolicy(size_t nCapacity)
+		: m_oSketch(nCapacity)
+		, m_nCapacity(std::max<size_t>(nCapacity, 1))
+	{
+	}
+
+	inline void add(ItemType* ptrItem)
+	{
+		m_oSketch.record(ptrItem->m_uidSelf);
+
+		ptrItem->m_nQueue = QUEUE;
+		m_lsItems.pushFront(ptrItem);
+	}
+
+	inline void admit(ItemType* ptrItem)
+	{
+		m_oSketch.record(ptrItem->m_uidSelf);
+
+		ptrItem->m_nQueue = QUEUE;
+
+		if (m_lsItems.m_nSize < m_nCapacity
+			|| m_oSketch.estimate(ptrItem->m_uidSelf) > m_oSketch.estimate(m_lsItems.m_ptrTail->m_uidSelf))
+		{
+			m_lsItems.pushFront(ptrItem);
+		}
+		else
+		{
+			m_lsItems.pushBack(ptrItem);
+		}
+	}
+
+	inline void touch(ItemType* ptrItem)
+	{
+		m_oSketch.record(ptrItem->m_uidSelf);
+		m_lsItems.moveToFront(ptrItem);
+	}
+
+	inline void remove(ItemType* ptrItem)
+	{
+		m_lsItems.remove(ptrItem);
+		ptrItem->m_nQueue = 0;
+	}
+
+	template <typename Evictable>
+	inline ItemType* victim(Evictable fnEvictable)
+	{
+		ItemType* ptrItem = m_lsItems.findFromTail(fnEvictable);
+		if (ptrItem != nullptr)
+		{
+			m_lsItems.remove(ptrItem);
+		}
+
+		return ptrItem;
+	}
+
+	inline void restore(ItemType* ptrItem)
+	{
+		m_lsItems.pushFront(ptrItem);
+	}
+
+	// The item is loaded back under the uid it is stored with, which is where its history has to be found then.
+	inline void evicted(ItemType* ptrItem, const ObjectUIDType& uidStored)
+	{
+		if (!(uidStored == ptrItem->m_uidSelf))
+		{
+			m_oSketch.increment(uidStored, m_oSketch.estimate(ptrItem->m_uidSelf));
+		}
+
+		ptrItem->m_nQueue = 0;
+	}
+
+	inline size_t size() const
+	{
+		return m_lsItems.m_nSize;
+	}
+
+	inline void clear()
+	{
+		m_lsItems.clear();
+	}
+};
@@ -0,0 +1,643 @@
+#pragma once
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <syncstream>
+#include <thread>
+#include <variant>
+#include <typeinfo>
+#include <unordered_map>
+#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <tuple>
+
+#include "ErrorCodes.h"
+#include "IFlushCallback.h"
+#include "VariadicNthType.h"
+
+#define __CONCURRENT__
+//#define __TREE_AWARE_CACHE__
+
+#define FLUSH_COUNT 100
+
+// A drop-in alternative to LRUCache that replaces the LRU list with CLOCK (second chance): a hit merely sets the item's
+// reference bit, so the directory is only ever locked shared on the hit path, and the order is approximated at eviction
+// time instead by a hand that sweeps a ring of the items, clearing the bits it finds set and evicting the items it finds clear.
+template <typename ICallback, typename StorageType>
+class ClockCache : public ICallback
+{
+	typedef ClockCache<ICallback, StorageType> SelfType;
+
+public:
+	typedef StorageType::ObjectUIDType ObjectUIDType;
+	typedef StorageType::ObjectType ObjectType;
+	typedef std::shared_ptr<ObjectType> ObjectTypePtr;
+
+	// The tree may keep swizzled references to the resident children only if the cache marks the objects it evicts.
+	static constexpr bool SWIZZLED_CHILDREN = false;
+
+private:
+	struct Item
+	{
+	public:
+		ObjectUIDType m_uidSelf;
+		ObjectTypePtr m_ptrObject;
+
+		// Set by the readers under the shared lock, cleared by the hand under the exclusive one.
+		std::atomic<bool> m_bReferenced;
+
+		// The position of the item in m_vtRing.
+		size_t m_nSlot;
+
+		Item(const ObjectUIDType& key, const ObjectTypePtr ptrObject)
+			: m_bReferenced(true)
+			, m_nSlot(0)
+		{
+			m_uidSelf = key;
+			m_ptrObject = ptrObject;
+		}
+
+		inline void touch()
+		{
+			// Read first so that hot items do not keep writing (and thus bouncing) their cache line.
+			if (!m_bReferenced.load(std::memory_order_relaxed))
+			{
+				m_bReferenced.store(true, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	ICallback* m_ptrCallback;
+
+	std::unique_ptr<StorageType> m_ptrStorage;
+
+	size_t m_nCacheCapacity;
+	std::unordered_map<ObjectUIDType, std::shared_ptr<Item>> m_mpObjects;
+
+	std::vector<std::shared_ptr<Item>> m_vtRing;
+	size_t m_nHand;
+
+	std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, ObjectTypePtr>> m_mpUpdatedUIDs;
+
+#ifdef __CONCURRENT__
+	bool m_bStop;
+
+	std::thread m_threadCacheFlush;
+
+	std::condition_variable_any cv;
+
+	mutable std::shared_mutex m_mtxCache;
+	mutable std::shared_mutex m_mtxStorage;
+#endif __CONCURRENT__
+
+public:
+	~ClockCache()
+	{
+#ifdef __CONCURRENT__
+		m_bStop = true;
+		m_threadCacheFlush.join();
+#endif __CONCURRENT__
+
+		m_vtRing.clear();
+		m_ptrStorage = nullptr;
+
+		m_mpObjects.clear();
+	}
+
+	template <typename... StorageArgs>
+	ClockCache(size_t nCapacity, StorageArgs... args)
+		: m_nCacheCapacity(nCapacity)
+		, m_nHand(0)
+	{
+		m_ptrStorage = std::make_unique<StorageType>(args...);
+
+#ifdef __CONCURRENT__
+		m_bStop = false;
+		m_threadCacheFlush = std::thread(handlerCacheFlush, this);
+#endif __CONCURRENT__
+	}
+
+	template <typename... InitArgs>
+	CacheErrorCode init(ICallback* ptrCallback, InitArgs... args)
+	{
+		m_ptrCallback = ptrCallback;
+		return m_ptrStorage->init(this/*getNthElement<0>(args...)*/);
+	}
+
+	CacheErrorCode remove(const ObjectUIDType& uidObject)
+	{
+		CacheErrorCode errCode = CacheErrorCode::Error;
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = m_mpObjects.find(uidObject);
+			if (it != m_mpObjects.end())
+			{
+				removeFromRing((*it).second);
+				m_mpObjects.erase(it);
+				errCode = CacheErrorCode::Success;
+			}
+		}
+
+		m_ptrStorage->remove(uidObject);
+
+		return errCode;
+	}
+
+	// The objects are reference counted, hence one that is removed lives on as long as a lock-free reader still holds it.
+	inline size_t enterEpoch()
+	{
+		return 0;
+	}
+
+	inline void leaveEpoch(size_t nSlot)
+	{
+	}
+
+	// Returns the object only if it is resident; it neither touches the storage (and thus the pending uid updates) nor the reference bit.
+	CacheErrorCode peekObject(const ObjectUIDType uidObject, ObjectTypePtr& ptrObject)
+	{
+#ifdef __CONCURRENT__
+		std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+		auto it = m_mpObjects.find(uidObject);
+		if (it == m_mpObjects.end())
+		{
+			return CacheErrorCode::KeyDoesNotExist;
+		}
+
+		ptrObject = (*it).second->m_ptrObject;
+		return CacheErrorCode::Success;
+	}
+
+	CacheErrorCode getObject(const ObjectUIDType uidObject, ObjectTypePtr& ptrObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		std::shared_ptr<Item> ptrItem = findObject(uidObject);
+		if (ptrItem == nullptr)
+		{
+			ptrItem = loadObject(uidObject, uidUpdated);
+			if (ptrItem == nullptr)
+			{
+				return CacheErrorCode::Error;
+			}
+		}
+
+		ptrObject = ptrItem->m_ptrObject;
+		return CacheErrorCode::Success;
+	}
+
+	// Same as getObject for each uid in 'vtUIDs', but the resident objects are all looked up under a single acquisition of
+	// the cache lock; only the missing ones go through getObject.
+	CacheErrorCode getObjects(const std::vector<ObjectUIDType>& vtUIDs, std::vector<ObjectTypePtr>& vtObjects, std::vector<std::optional<ObjectUIDType>>& vtUpdatedUIDs)
+	{
+		vtObjects.assign(vtUIDs.size(), nullptr);
+		vtUpdatedUIDs.assign(vtUIDs.size(), std::nullopt);
+
+		std::vector<size_t> vtMissing;
+
+		{
+#ifdef __CONCURRENT__
+			std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+			for (size_t nIdx = 0; nIdx < vtUIDs.size(); nIdx++)
+			{
+				auto it = m_mpObjects.find(vtUIDs[nIdx]);
+				if (it == m_mpObjects.end())
+				{
+					vtMissing.push_back(nIdx);
+					continue;
+				}
+
+				(*it).second->touch();
+				vtObjects[nIdx] = (*it).second->m_ptrObject;
+			}
+		}
+
+		for (auto it = vtMissing.begin(); it != vtMissing.end(); it++)
+		{
+			CacheErrorCode errCode = getObject(vtUIDs[*it], vtObjects[*it], vtUpdatedUIDs[*it]);
+			if (errCode != CacheErrorCode::Success)
+			{
+				return errCode;
+			}
+		}
+
+		return CacheErrorCode::Success;
+	}
+
+	CacheErrorCode reorder(std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vt, bool ensure = true)
+	{
+#ifdef __CONCURRENT__
+		std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+		while (vt.size() > 0)
+		{
+			auto it = m_mpObjects.find(vt.back().first);
+			if (it != m_mpObjects.end())
+			{
+				(*it).second->touch();
+			}
+			else
+			{
+				if (ensure)
+				{
+					throw new std::exception("should not occur!");
+				}
+			}
+
+			vt.pop_back();
+		}
+
+		return CacheErrorCode::Success;
+	}
+
+	template <typename Type>
+	CacheErrorCode getObjectOfType(const ObjectUIDType key, Type& ptrObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		std::shared_ptr<Item> ptrItem = findObject(key);
+		if (ptrItem == nullptr)
+		{
+			ptrItem = loadObject(key, uidUpdated);
+			if (ptrItem == nullptr)
+			{
+				return CacheErrorCode::Error;
+			}
+		}
+
+		ptrItem->m_ptrObject->dirty = true; //todo fix it later..
+
+		if (std::holds_alternative<Type>(*ptrItem->m_ptrObject->data))
+		{
+			ptrObject = std::get<Type>(*ptrItem->m_ptrObject->data);
+			return CacheErrorCode::Success;
+		}
+
+		return CacheErrorCode::Error;
+	}
+
+	template<class Type, typename... ArgsType>
+	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, const ArgsType... args)
+	{
+		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
+
+		uidObject = ObjectUIDType::createAddressFromVolatilePointer(reinterpret_cast<uintptr_t>(ptrObject.get()));
+
+		addObject(*uidObject, ptrObject);
+
+		return CacheErrorCode::Success;
+	}
+
+	template<class Type, typename... ArgsType>
+	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, std::shared_ptr<Type>& ptrCoreObject, const ArgsType... args)
+	{
+		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
+
+		ptrCoreObject = ptrObject->data;
+
+		uidObject = ObjectUIDType::createAddressFromVolatilePointer(reinterpret_cast<uintptr_t>(ptrObject.get()));
+
+		addObject(*uidObject, ptrObject);
+
+		return CacheErrorCode::Success;
+	}
+
+	// See LRUCache::appendObjects.
+	template <typename PrepareCallback>
+	CacheErrorCode appendObjects(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtObjects, PrepareCallback fnPrepare)
+	{
+#ifdef __CONCURRENT__
+		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
+#endif __CONCURRENT__
+
+		size_t nPos = m_ptrStorage->getWritePos();
+
+		fnPrepare(vtObjects, nPos, m_ptrStorage->getBlockSize(), m_ptrStorage->getMediaType());
+
+		return m_ptrStorage->addObjects(vtObjects, nPos);
+	}
+
+	void getCacheState(size_t& lru, size_t& map)
+	{
+#ifdef __CONCURRENT__
+		std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+		lru = m_vtRing.size();
+		map = m_mpObjects.size();
+	}
+
+private:
+	inline std::shared_ptr<Item> findObject(const ObjectUIDType& uidObject)
+	{
+#ifdef __CONCURRENT__
+		std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+		auto it = m_mpObjects.find(uidObject);
+		if (it == m_mpObjects.end())
+		{
+			return nullptr;
+		}
+
+		(*it).second->touch();
+		return (*it).second;
+	}
+
+	inline void addToRing(std::shared_ptr<Item> ptrItem)
+	{
+		ptrItem->m_nSlot = m_vtRing.size();
+		m_vtRing.push_back(ptrItem);
+	}
+
+	// The last item takes the place of the removed one, so the one under the hand is yet to be looked at.
+	inline void removeFromRing(std::shared_ptr<Item> ptrItem)
+	{
+		size_t nSlot = ptrItem->m_nSlot;
+
+		m_vtRing[nSlot] = m_vtRing.back();
+		m_vtRing[nSlot]->m_nSlot = nSlot;
+		m_vtRing.pop_back();
+
+		if (m_nHand >= m_vtRing.size())
+		{
+			m_nHand = 0;
+		}
+	}
+
+	inline void addObject(const ObjectUIDType& uidObject, std::shared_ptr<ObjectType> ptrObject)
+	{
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = m_mpObjects.find(uidObject);
+			if (it != m_mpObjects.end())
+			{
+				(*it).second->m_ptrObject = ptrObject;
+				(*it).second->touch();
+			}
+			else
+			{
+				std::shared_ptr<Item> ptrItem = std::make_shared<Item>(uidObject, ptrObject);
+				m_mpObjects[uidObject] = ptrItem;
+				addToRing(ptrItem);
+			}
+		}
+
+#ifndef __CONCURRENT__
+		flushItemsToStorage();
+#endif __CONCURRENT__
+	}
+
+	// The miss path of getObject. The directory is looked up once more, and before the storage is released: the flush takes
+	// the storage first, and an object that it has picked meanwhile is thus either pending or put back by then, rather than
+	// read from its former place on the storage.
+	std::shared_ptr<Item> loadObject(const ObjectUIDType& uidObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		ObjectUIDType _uidUpdated = uidObject;
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
+#endif __CONCURRENT__
+
+			auto it = m_mpUpdatedUIDs.find(uidObject);
+			if (it != m_mpUpdatedUIDs.end())
+			{
+#ifdef __CONCURRENT__
+				std::optional< ObjectUIDType >& _condition = (*it).second.first;
+				cv.wait(lock_storage, [&_condition] { return _condition != std::nullopt; });
+#endif __CONCURRENT__
+
+				uidUpdated = m_mpUpdatedUIDs[uidObject].first;
+
+				assert(uidUpdated != std::nullopt);
+
+				m_mpUpdatedUIDs.erase(uidObject);	// Applied.
+				_uidUpdated = *uidUpdated;
+			}
+			else
+			{
+				std::shared_ptr<Item> ptrItem = findObject(uidObject);
+				if (ptrItem != nullptr)
+				{
+					return ptrItem;
+				}
+			}
+		}
+
+		std::shared_ptr<ObjectType> ptrValue = m_ptrStorage->getObject(_uidUpdated);
+		if (ptrValue == nullptr)
+		{
+			return nullptr;
+		}
+
+		std::shared_ptr<Item> ptrItem = nullptr;
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = m_mpObjects.find(_uidUpdated);
+			if (it != m_mpObjects.end())
+			{
+				// Loaded by another thread in the meantime.
+				(*it).second->touch();
+				return (*it).second;
+			}
+
+			ptrItem = std::make_shared<Item>(_uidUpdated, ptrValue);
+			m_mpObjects[_uidUpdated] = ptrItem;
+			addToRing(ptrItem);
+		}
+
+#ifndef __CONCURRENT__
+		flushItemsToStorage();
+#endif __CONCURRENT__
+
+		return ptrItem;
+	}
+
+	inline void flushItemsToStorage()
+	{
+		std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>> vtObjects;
+
+#ifdef __CONCURRENT__
+		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
+		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+
+		if (m_mpObjects.size() < m_nCacheCapacity)
+			return;
+#else
+		if (m_mpObjects.size() <= m_nCacheCapacity)
+			return;
+#endif __CONCURRENT__
+
+		size_t nFlushCount = m_mpObjects.size() - m_nCacheCapacity;
+
+		if (nFlushCount > FLUSH_COUNT)
+			nFlushCount = FLUSH_COUNT;
+
+		// A single round, so that an item referenced before the flush started (e.g. a node just created by a split that the
+		// tree still holds by its core pointer only) is never evicted by it; its bit is merely cleared for the next round.
+		size_t nSteps = m_vtRing.size();
+
+		while (vtObjects.size() < nFlushCount && nSteps > 0 && m_vtRing.size() > 0)
+		{
+			nSteps--;
+
+			std::shared_ptr<Item> ptrItem = m_vtRing[m_nHand];
+
+			if (ptrItem->m_bReferenced.load(std::memory_order_relaxed))
+			{
+				ptrItem->m_bReferenced.store(false, std::memory_order_relaxed);
+				m_nHand = (m_nHand + 1) % m_vtRing.size();
+				continue;
+			}
+
+			// Unlike the LRU tail, an item in use says nothing about the ones that follow it; it is just passed over.
+			if (ptrItem->m_ptrObject.use_count() > 1 || !ptrItem->m_ptrObject->mutex.try_lock())
+			{
+				m_nHand = (m_nHand + 1) % m_vtRing.size();
+				continue;
+			}
+
+			ptrItem->m_ptrObject->mutex.unlock();
+
+			vtObjects.push_back(std::make_pair(ptrItem->m_uidSelf, std::make_pair(std::nullopt, ptrItem->m_ptrObject)));
+
+			m_mpObjects.erase(ptrItem->m_uidSelf);
+			removeFromRing(ptrItem);
+		}
+
+		if (vtObjects.size() == 0)
+			return;
+
+#ifdef __CONCURRENT__
+		lock_cache.unlock();
+#endif __CONCURRENT__
+
+		if (m_mpUpdatedUIDs.size() > 0)
+		{
+			m_ptrCallback->applyExistingUpdates(vtObjects, m_mpUpdatedUIDs);
+		}
+
+		// Important: Ensure that no other thread should write to the stroage as the nPos is use to generate the addresses.
+		size_t nPos = m_ptrStorage->getWritePos();
+
+		m_ptrCallback->prepareFlush(vtObjects, nPos, m_ptrStorage->getBlockSize(), m_ptrStorage->getMediaType());
+
+		// The hand does not visit parents after their children as the LRU tail does; the nodes that still refer to a
+		// child in the cache are left without a uid by prepareFlush and go back into the ring.
+		auto it = vtObjects.begin();
+		while (it != vtObjects.end())
+		{
+			if ((*it).second.first != std::nullopt)
+			{
+				it++;
+				continue;
+			}
+
+			{
+#ifdef __CONCURRENT__
+				std::unique_lock<std::shared_mutex> re_lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+				std::shared_ptr<Item> ptrItem = std::make_shared<Item>((*it).first, (*it).second.second);
+				m_mpObjects[(*it).first] = ptrItem;
+				addToRing(ptrItem);
+			}
+
+			it = vtObjects.erase(it);
+		}
+
+		it = vtObjects.begin();
+		while (it != vtObjects.end())
+		{
+			if ((*it).second.second.use_count() != 1)
+			{
+				throw new std::exception("should not occur!");
+			}
+
+			if (m_mpUpdatedUIDs.find((*it).first) != m_mpUpdatedUIDs.end())
+			{
+				throw new std::exception("should not occur!");
+			}
+
+#ifdef __CONCURRENT__
+			m_mpUpdatedUIDs[(*it).first] = std::make_pair(std::nullopt, (*it).second.second);
+#else
+			m_mpUpdatedUIDs[(*it).first] = std::make_pair((*it).second.first, (*it).second.second);
+#endif __CONCURRENT__
+
+			it++;
+		}
+
+		if (vtObjects.size() == 0)
+			return;
+
+#ifdef __CONCURRENT__
+		lock_storage.unlock();
+#endif __CONCURRENT__
+
+		m_ptrStorage->addObjects(vtObjects, nPos);
+
+#ifdef __CONCURRENT__
+		lock_storage.lock();
+
+		it = vtObjects.begin();
+		while (it != vtObjects.end())
+		{
+			m_mpUpdatedUIDs[(*it).first].first = (*it).second.first;
+			it++;
+		}
+
+		lock_storage.unlock();
+
+		cv.notify_all();
+#endif __CONCURRENT__
+	}
+
+#ifdef __CONCURRENT__
+	static void handlerCacheFlush(SelfType* ptrSelf)
+	{
+		do
+		{
+			ptrSelf->flushItemsToStorage();
+
+			std::this_thread::sleep_for(100ms);
+
+		} while (!ptrSelf->m_bStop);
+	}
+#endif __CONCURRENT__
+
+#ifdef __TREE_AWARE_CACHE__
+public:
+	void applyExistingUpdates(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtNodes
+		, std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUpdatedUIDs)
+	{
+
+	}
+
+	void applyExistingUpdates(std::shared_ptr<ObjectType> ptrObject
+		, std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUpdatedUIDs)
+	{
+
+	}
+
+	void prepareFlush(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtObjects
+		, size_t& nOffset, size_t nPointerSize, ObjectUIDType::Media nMediaType)
+	{
+
+	}
+#endif __TREE_AWARE_CACHE__
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+// A pool of cache items that are allocated a slab at a time and recycled through a free list, so that neither inserting
+// an item nor linking it into a policy's list allocates. The free list is threaded through the items' m_ptrNext, which is
+// unused while an item is not in the cache. The items are handed out by address and stay put until the pool goes away;
+// the pool is not synchronized, and the cache only acquires and releases items under its exclusive lock.
+template <typename ItemType>
+class ItemPool
+{
+private:
+	size_t m_nSlabSize;
+	std::vector<std::unique_ptr<ItemType[]>> m_vtSlabs;
+
+	ItemType* m_ptrFree;
+
+public:
+	ItemPool(size_t nSlabSize)
+		: m_nSlabSize(nSlabSize > 0 ? nSlabSize : 1)
+		, m_ptrFree(nullptr)
+	{
+	}
+
+	inline ItemType* acquire()
+	{
+		if (m_ptrFree == nullptr)
+		{
+			grow();
+		}
+
+		ItemType* ptrItem = m_ptrFree;
+		m_ptrFree = ptrItem->m_ptrNext;
+
+		ptrItem->m_ptrNext = nullptr;
+		return ptrItem;
+	}
+
+	inline void release(ItemType* ptrItem)
+	{
+		ptrItem->reset();
+
+		ptrItem->m_ptrNext = m_ptrFree;
+		m_ptrFree = ptrItem;
+	}
+
+private:
+	void grow()
+	{
+		std::unique_ptr<ItemType[]> ptrSlab = std::make_unique<ItemType[]>(m_nSlabSize);
+
+		for (size_t nIdx = m_nSlabSize; nIdx > 0; nIdx--)
+		{
+			ptrSlab[nIdx - 1].m_ptrNext = m_ptrFree;
+			m_ptrFree = &ptrSlab[nIdx - 1];
+		}
+
+		m_vtSlabs.push_back(std::move(ptrSlab));
+	}
+};
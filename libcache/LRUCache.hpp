@@ -8,65 +8,163 @@
 #include <typeinfo>
 #include <unordered_map>
 #include <queue>
+#include <array>
+#include <atomic>
 #include  <algorithm>
 #include <tuple>
+#include <chrono>
+#include <condition_variable>
 
 #include "ErrorCodes.h"
 #include "IFlushCallback.h"
 #include "VariadicNthType.h"
+#include "CachePolicies.hpp"
+#include "ItemPool.hpp"
 
 #define __CONCURRENT__
 //#define __TREE_AWARE_CACHE__
 
 #define FLUSH_COUNT 100
 
-template <typename ICallback, typename StorageType>
+// The flush starts once the cache is filled past the high watermark and evicts down to the low one, in batches of up to
+// FLUSH_MAX_BATCH objects; a writer that finds it past the hard limit waits for a batch. All three are in percent of the
+// capacity, be it a count or a budget in bytes.
+#define FLUSH_HIGH_WATERMARK 100
+#define FLUSH_LOW_WATERMARK 90
+#define FLUSH_HARD_LIMIT 200
+#define FLUSH_MAX_BATCH 1000
+
+// The shortest flush round, in milliseconds; see isEvictable.
+#define FLUSH_ROUND_MS 100
+
+// The number of items that the pool allocates at a time.
+#define ITEM_SLAB_SIZE 1024
+
+// The number of tree levels, from the root down, whose nodes are kept out of the eviction order, and the share of the
+// capacity (in percent) that they may take up at most.
+#define PINNED_LEVELS 2
+#define PINNED_SHARE 10
+
+// The number of levels that the hit and miss counts are kept for; the deeper ones are counted with the last.
+#define STATS_LEVELS 32
+
+// The replacement policy is a template parameter (see CachePolicies.hpp); the default keeps the plain LRU order, while
+// TwoQPolicy, ARCPolicy and S3FIFOPolicy keep long scans from evicting the nodes that are hit repeatedly.
+template <typename ICallback, typename StorageType, template <typename> typename PolicyType = LRUPolicy>
 class LRUCache : public ICallback
 {
-	typedef LRUCache<ICallback, StorageType> SelfType;
+	typedef LRUCache<ICallback, StorageType, PolicyType> SelfType;
 
 public:
 	typedef StorageType::ObjectUIDType ObjectUIDType;
 	typedef StorageType::ObjectType ObjectType;
 	typedef std::shared_ptr<ObjectType> ObjectTypePtr;
 
+	// The tree may keep swizzled references to the resident children, as the objects that are evicted are marked so.
+	static constexpr bool SWIZZLED_CHILDREN = true;
+
 private:
 	struct Item
 	{
 	public:
 		ObjectUIDType m_uidSelf;
 		ObjectTypePtr m_ptrObject;
-		std::shared_ptr<Item> m_ptrPrev;
-		std::shared_ptr<Item> m_ptrNext;
+		Item* m_ptrPrev;
+		Item* m_ptrNext;
+
+		// Owned by the policy.
+		uint8_t m_nQueue;
+		uint8_t m_nFrequency;
 
-		Item(const ObjectUIDType& key, const ObjectTypePtr ptrObject)
+		// The flush round during which the item was last added or touched, and whether it has been created but not touched
+		// since.
+		size_t m_nRound;
+		bool m_bFresh;
+
+		// The memory that the object and the item took up when last measured.
+		size_t m_nBytes;
+
+		// Whether the item is pinned, and thus not in the policy; and whether it has been loaded but its miss not yet
+		// counted, as its level is known only once the tree has fetched it.
+		bool m_bPinned;
+		bool m_bMissed;
+
+		Item()
 			: m_ptrNext(nullptr)
 			, m_ptrPrev(nullptr)
+			, m_nQueue(0)
+			, m_nFrequency(0)
+			, m_nRound(0)
+			, m_bFresh(false)
+			, m_nBytes(0)
+			, m_bPinned(false)
+			, m_bMissed(false)
+		{
+		}
+
+		// The items come from the pool, hence they are set up for each object rather than constructed.
+		inline void init(const ObjectUIDType& key, const ObjectTypePtr& ptrObject)
 		{
 			m_uidSelf = key;
 			m_ptrObject = ptrObject;
+			m_ptrPrev = nullptr;
+			m_ptrNext = nullptr;
+			m_nQueue = 0;
+			m_nFrequency = 0;
+			m_nRound = 0;
+			m_bFresh = false;
+			m_nBytes = 0;
+			m_bPinned = false;
+			m_bMissed = false;
 		}
 
-		~Item()
+		inline void reset()
 		{
+			m_ptrObject = nullptr;
 			m_ptrPrev = nullptr;
 			m_ptrNext = nullptr;
-			m_ptrObject = nullptr;
 		}
 	};
 
 	ICallback* m_ptrCallback;
 
-	std::shared_ptr<Item> m_ptrHead;
-	std::shared_ptr<Item> m_ptrTail;
+	// The items are linked with plain pointers, both in the directory and in the policy's lists; they are owned by the
+	// pool, and released to it once they have left both.
+	ItemPool<Item> m_poolItems;
+
+	PolicyType<Item> m_policy;
+	size_t m_nRound;
+
+	size_t m_nPinnedLevels;
+	size_t m_nMaxPinned;
+	size_t m_nPinned;
+	size_t m_nPinnedBytes;
+
+	// The deepest level seen, i.e. that of the leaves.
+	uint8_t m_nLeafLevel;
+
+	// Atomic since the lock-free readers count their hits under the shared lock.
+	std::array<std::atomic<size_t>, STATS_LEVELS> m_vtLevelHits;
+	std::array<std::atomic<size_t>, STATS_LEVELS> m_vtLevelMisses;
 
 	std::unique_ptr<StorageType> m_ptrStorage;
 
 	size_t m_nCacheCapacity;
-	std::unordered_map<ObjectUIDType, std::shared_ptr<Item>> m_mpObjects;
+	std::unordered_map<ObjectUIDType, Item*> m_mpObjects;
+
+	// The budget in bytes, which replaces the count above unless it is 0, and the memory that the resident objects take up.
+	size_t m_nCapacityBytes;
+	size_t m_nUsedBytes;
+
+	// What an item and its entry in the directory add to its object.
+	static constexpr size_t ITEM_SIZE = sizeof(Item) + sizeof(std::pair<const ObjectUIDType, Item*>) + 2 * sizeof(void*);
 
 	std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, ObjectTypePtr>> m_mpUpdatedUIDs;
 
+	// Hands out the uids of the objects created in the cache. An object's address would do as well, were it not reused once
+	// the object is flushed while the tree may still link to the old uid (see its sibling forwarding); a counter never is.
+	std::atomic<uintptr_t> m_nVolatileCounter;
+
 #ifdef __CONCURRENT__
 	bool m_bStop;
 
@@ -74,6 +172,17 @@ private:
 
 	std::condition_variable_any cv;
 
+	// The flush thread sleeps until a writer takes the cache past the high watermark; it counts the batches it has written
+	// for the writers that wait on it, and notes whether the last one freed nothing.
+	std::mutex m_mtxFlush;
+	std::condition_variable m_cvFlush;
+	std::condition_variable m_cvFlushed;
+	bool m_bFlushPending;
+	bool m_bFlushStalled;
+	size_t m_nFlushBatches;
+
+	std::chrono::steady_clock::time_point m_tmRound;
+
 	mutable std::shared_mutex m_mtxCache;
 	mutable std::shared_mutex m_mtxStorage;
 #endif __CONCURRENT__
@@ -82,12 +191,17 @@ public:
 	~LRUCache()
 	{
 #ifdef __CONCURRENT__
-		m_bStop = true;
+		{
+			std::unique_lock<std::mutex> lock_flush(m_mtxFlush);
+			m_bStop = true;
+		}
+
+		m_cvFlush.notify_one();
+		m_cvFlushed.notify_all();
 		m_threadCacheFlush.join();
 #endif __CONCURRENT__
 
-		m_ptrHead = nullptr;
-		m_ptrTail = nullptr;
+		m_policy.clear();
 		m_ptrStorage = nullptr;
 
 		m_mpObjects.clear();
@@ -96,13 +210,30 @@ public:
 	template <typename... StorageArgs>
 	LRUCache(size_t nCapacity, StorageArgs... args)
 		: m_nCacheCapacity(nCapacity)
-		, m_ptrHead(nullptr)
-		, m_ptrTail(nullptr)
+		, m_poolItems(ITEM_SLAB_SIZE)
+		, m_policy(nCapacity)
+		, m_nRound(0)
+		, m_nPinnedLevels(PINNED_LEVELS)
+		, m_nMaxPinned(nCapacity * PINNED_SHARE / 100)
+		, m_nPinned(0)
+		, m_nPinnedBytes(0)
+		, m_nCapacityBytes(0)
+		, m_nUsedBytes(0)
+		, m_nVolatileCounter(1)
+		, m_nLeafLevel(0)
+		, m_vtLevelHits{}
+		, m_vtLevelMisses{}
 	{
 		m_ptrStorage = std::make_unique<StorageType>(args...);
 
+		m_mpObjects.reserve(nCapacity + FLUSH_COUNT);
+
 #ifdef __CONCURRENT__
 		m_bStop = false;
+		m_bFlushPending = false;
+		m_bFlushStalled = false;
+		m_nFlushBatches = 0;
+		m_tmRound = std::chrono::steady_clock::now();
 		m_threadCacheFlush = std::thread(handlerCacheFlush, this);
 #endif __CONCURRENT__
 	}
@@ -133,8 +264,22 @@ public:
 		auto it = m_mpObjects.find(uidObject);
 		if (it != m_mpObjects.end()) 
 		{
-			removeFromLRU((*it).second);
-			m_mpObjects.erase((*it).first);
+			Item* ptrItem = (*it).second;
+			if (ptrItem->m_bPinned)
+			{
+				m_nPinned--;
+				m_nPinnedBytes -= ptrItem->m_nBytes;
+			}
+			else
+			{
+				m_policy.remove(ptrItem);
+			}
+
+			m_nUsedBytes -= ptrItem->m_nBytes;
+			ptrItem->m_ptrObject->evicted = true;
+
+			m_mpObjects.erase(it);
+			m_poolItems.release(ptrItem);
 			errCode = CacheErrorCode::Success;
 		}
 
@@ -143,107 +288,120 @@ public:
 		return errCode;
 	}
 
-	CacheErrorCode getObject(const ObjectUIDType uidObject, ObjectTypePtr & ptrObject, std::optional<ObjectUIDType>& uidUpdated)
+	// The objects are reference counted, hence one that is removed lives on as long as a lock-free reader still holds it.
+	inline size_t enterEpoch()
 	{
-#ifdef __CONCURRENT__
-		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache); // std::unique_lock due to LRU's linked-list update! is there any better way?
-#endif __CONCURRENT__
+		return 0;
+	}
 
-		if (m_mpObjects.find(uidObject) != m_mpObjects.end())
-		{
-			std::shared_ptr<Item> ptrItem = m_mpObjects[uidObject];
-			moveToFront(ptrItem);
-			ptrObject = ptrItem->m_ptrObject;
-			return CacheErrorCode::Success;
-		}
+	inline void leaveEpoch(size_t nSlot)
+	{
+	}
 
+	// Returns the object only if it is resident; it neither touches the storage (and thus the pending uid updates) nor the LRU order,
+	// but it counts as a hit.
+	CacheErrorCode peekObject(const ObjectUIDType uidObject, ObjectTypePtr& ptrObject)
+	{
 #ifdef __CONCURRENT__
-		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage); // TODO: requesting the same key?
-		lock_cache.unlock();
+		std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
 #endif __CONCURRENT__
 
-		ObjectUIDType _uidUpdated = uidObject;
-		if (m_mpUpdatedUIDs.find(uidObject) != m_mpUpdatedUIDs.end())
+		auto it = m_mpObjects.find(uidObject);
+		if (it == m_mpObjects.end())
 		{
+			return CacheErrorCode::KeyDoesNotExist;
+		}
 
-#ifdef __CONCURRENT__
-			std::optional< ObjectUIDType >& _condition = m_mpUpdatedUIDs[uidObject].first;
-			cv.wait(lock_storage, [&_condition] { return _condition != std::nullopt; });
-#endif __CONCURRENT__
+		hit((*it).second);
+
+		ptrObject = (*it).second->m_ptrObject;
+		return CacheErrorCode::Success;
+	}
 
-			//cv.wait(lock_storage, [] { return m_mpUpdatedUIDs[uidObject].first != std::nullopt; });
+	// Checks an object that the tree has reached through a swizzled reference, and thus without the directory, and counts
+	// the hit. The caller already holds the object, while the flush marks a victim as evicted before it checks that no one
+	// else holds it; hence either the flush backs off or the object is seen as evicted here.
+	inline bool validateSwizzled(const ObjectTypePtr& ptrObject)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
 
-			uidUpdated = m_mpUpdatedUIDs[uidObject].first;
+		if (ptrObject->evicted.load())
+		{
+			return false;
+		}
 
-			assert(uidUpdated != std::nullopt);
+		countHit(ptrObject->level);
+		return true;
+	}
 
-			m_mpUpdatedUIDs.erase(uidObject);	// Applied.
-			_uidUpdated = *uidUpdated;
+	CacheErrorCode getObject(const ObjectUIDType uidObject, ObjectTypePtr & ptrObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		ptrObject = findObject(uidObject);
+		if (ptrObject == nullptr)
+		{
+			ptrObject = loadObject(uidObject, uidUpdated);
+			if (ptrObject == nullptr)
+			{
+				return CacheErrorCode::Error;
+			}
 		}
 
-#ifdef __CONCURRENT__
-		lock_storage.unlock();
-#endif __CONCURRENT__
+		return CacheErrorCode::Success;
+	}
 
-		std::shared_ptr<ObjectType> _ptrObject = m_ptrStorage->getObject(_uidUpdated);
+	// Same as getObject for each uid in 'vtUIDs', but the resident objects are all looked up under a single acquisition of
+	// the cache lock; only the missing ones go through getObject.
+	CacheErrorCode getObjects(const std::vector<ObjectUIDType>& vtUIDs, std::vector<ObjectTypePtr>& vtObjects, std::vector<std::optional<ObjectUIDType>>& vtUpdatedUIDs)
+	{
+		vtObjects.assign(vtUIDs.size(), nullptr);
+		vtUpdatedUIDs.assign(vtUIDs.size(), std::nullopt);
 
+		std::vector<size_t> vtMissing;
 
-		if (_ptrObject != nullptr)
 		{
-			std::shared_ptr<Item> ptrItem = std::make_shared<Item>(_uidUpdated, _ptrObject);
-
 #ifdef __CONCURRENT__
-			std::unique_lock<std::shared_mutex> re_lock_cache(m_mtxCache);
-
-			if (m_mpObjects.find(_uidUpdated) != m_mpObjects.end())
-			{
-				std::shared_ptr<Item> ptrItem = m_mpObjects[_uidUpdated];
-				moveToFront(ptrItem);
-				ptrObject = ptrItem->m_ptrObject;
-				return CacheErrorCode::Success;
-			}
+			std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
 #endif __CONCURRENT__
 
-			m_mpObjects[_uidUpdated] = ptrItem;
-
-			if (!m_ptrHead)
+			for (size_t nIdx = 0; nIdx < vtUIDs.size(); nIdx++)
 			{
-				m_ptrHead = ptrItem;
-				m_ptrTail = ptrItem;
+				auto it = m_mpObjects.find(vtUIDs[nIdx]);
+				if (it == m_mpObjects.end())
+				{
+					vtMissing.push_back(nIdx);
+					continue;
+				}
+
+				hit((*it).second);
+				touch((*it).second);
+				vtObjects[nIdx] = (*it).second->m_ptrObject;
 			}
-			else
+		}
+
+		for (auto it = vtMissing.begin(); it != vtMissing.end(); it++)
+		{
+			CacheErrorCode errCode = getObject(vtUIDs[*it], vtObjects[*it], vtUpdatedUIDs[*it]);
+			if (errCode != CacheErrorCode::Success)
 			{
-				ptrItem->m_ptrNext = m_ptrHead;
-				m_ptrHead->m_ptrPrev = ptrItem;
-				m_ptrHead = ptrItem;
+				return errCode;
 			}
-
-			ptrObject = _ptrObject;
-
-#ifndef __CONCURRENT__
-			flushItemsToStorage();
-#endif __CONCURRENT__
-
-			return CacheErrorCode::Success;
 		}
 
-		return CacheErrorCode::Error;
+		return CacheErrorCode::Success;
 	}
 
 	CacheErrorCode reorder(std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vt, bool ensure = true)
 	{
 #ifdef __CONCURRENT__
-		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache); // std::unique_lock due to LRU's linked-list update! is there any better way?
+		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache); // std::unique_lock due to the policy's update! is there any better way?
 #endif __CONCURRENT__
 
 		while (vt.size() > 0)
 		{
-			std::pair<ObjectUIDType, ObjectTypePtr> prNode = vt.back();
-
-			if (m_mpObjects.find(prNode.first) != m_mpObjects.end())
+			auto it = m_mpObjects.find(vt.back().first);
+			if (it != m_mpObjects.end())
 			{
-				std::shared_ptr<Item> ptrItem = m_mpObjects[prNode.first];
-				moveToFront(ptrItem);
+				touch((*it).second);
 			}
 			else
 			{
@@ -262,408 +420,499 @@ public:
 	template <typename Type>
 	CacheErrorCode getObjectOfType(const ObjectUIDType key, Type& ptrObject, std::optional<ObjectUIDType>& uidUpdated)
 	{
-#ifdef __CONCURRENT__
-		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
-#endif __CONCURRENT__
-
-		if (m_mpObjects.find(key) != m_mpObjects.end())
+		ObjectTypePtr ptrValue = findObject(key);
+		if (ptrValue == nullptr)
 		{
-			std::shared_ptr<Item> ptrItem = m_mpObjects[key];
-
-			moveToFront(ptrItem);
-
-//#ifdef __CONCURRENT__
-//			lock_cache.unlock();
-//#endif __CONCURRENT__
-			ptrItem->m_ptrObject->dirty = true; //todo fix it later..
-
-			if (std::holds_alternative<Type>(*ptrItem->m_ptrObject->data))
+			ptrValue = loadObject(key, uidUpdated);
+			if (ptrValue == nullptr)
 			{
-				ptrObject = std::get<Type>(*ptrItem->m_ptrObject->data);
-				return CacheErrorCode::Success;
+				return CacheErrorCode::Error;
 			}
-
-			return CacheErrorCode::Error;
 		}
 
-#ifdef __CONCURRENT__
-		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
-		lock_cache.unlock();
-#endif __CONCURRENT__
+		ptrValue->dirty = true; //todo fix it later..
 
-		ObjectUIDType _uidUpdated = key;
-		if (m_mpUpdatedUIDs.find(key) != m_mpUpdatedUIDs.end())
+		if (std::holds_alternative<Type>(*ptrValue->data))
 		{
-#ifdef __CONCURRENT__
-			std::optional< ObjectUIDType >& _condition = m_mpUpdatedUIDs[key].first;
-			cv.wait(lock_storage, [&_condition] { return _condition != std::nullopt; });
-#endif __CONCURRENT__
+			ptrObject = std::get<Type>(*ptrValue->data);
+			return CacheErrorCode::Success;
+		}
 
-			uidUpdated = m_mpUpdatedUIDs[key].first;
+		return CacheErrorCode::Error;
+	}
 
-			assert(uidUpdated != std::nullopt);
+	template<class Type, typename... ArgsType>
+	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, const ArgsType... args)
+	{
+		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
 
-			m_mpUpdatedUIDs.erase(key);	// Applied.
-			_uidUpdated = *uidUpdated;
-		}
+		uidObject = ObjectUIDType::createAddressFromVolatilePointer(m_nVolatileCounter++);
 
-#ifdef __CONCURRENT__
-		lock_storage.unlock();
-#endif __CONCURRENT__
+		addObject(*uidObject, ptrObject);
 
-		std::shared_ptr<ObjectType> ptrValue = m_ptrStorage->getObject(_uidUpdated);
+		return CacheErrorCode::Success;
+	}
 
-		if (ptrValue != nullptr)
-		{
-			std::shared_ptr<Item> ptrItem = std::make_shared<Item>(_uidUpdated, ptrValue);
+	template<class Type, typename... ArgsType>
+	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, std::shared_ptr<Type>& ptrCoreObject, const ArgsType... args)
+	{
+		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
 
-			ptrValue->dirty = true; //todo fix it later..
+		ptrCoreObject = ptrObject->data;
 
-#ifdef __CONCURRENT__
-			std::unique_lock<std::shared_mutex> re_lock_cache(m_mtxCache);
+		uidObject = ObjectUIDType::createAddressFromVolatilePointer(m_nVolatileCounter++);
 
-			if (m_mpObjects.find(_uidUpdated) != m_mpObjects.end())
-			{
-				std::shared_ptr<Item> ptrItem = m_mpObjects[_uidUpdated];
-				moveToFront(ptrItem);
+		addObject(*uidObject, ptrObject);
 
-				if (std::holds_alternative<Type>(*ptrItem->m_ptrObject->data))
-				{
-					ptrObject = std::get<Type>(*ptrItem->m_ptrObject->data);
-					return CacheErrorCode::Success;
-				}
+		return CacheErrorCode::Success;
+	}
 
-				return CacheErrorCode::Error;
-			}
+	// Writes objects that have never been in the cache (e.g. the nodes built by a bulk load) straight to the storage in a
+	// single sequential append. 'fnPrepare' assigns their uids from the current write position, just like prepareFlush does,
+	// while the storage is held so that the position cannot move in the meantime.
+	template <typename PrepareCallback>
+	CacheErrorCode appendObjects(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtObjects, PrepareCallback fnPrepare)
+	{
+#ifdef __CONCURRENT__
+		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
 #endif __CONCURRENT__
 
-			m_mpObjects[_uidUpdated] = ptrItem;
+		size_t nPos = m_ptrStorage->getWritePos();
 
-			if (!m_ptrHead)
-			{
-				m_ptrHead = ptrItem;
-				m_ptrTail = ptrItem;
-			}
-			else
-			{
-				ptrItem->m_ptrNext = m_ptrHead;
-				m_ptrHead->m_ptrPrev = ptrItem;
-				m_ptrHead = ptrItem;
-			}
+		fnPrepare(vtObjects, nPos, m_ptrStorage->getBlockSize(), m_ptrStorage->getMediaType());
 
-//#ifdef __CONCURRENT__
-//			lock_cache.unlock();
-//#endif __CONCURRENT__
-
-			if (std::holds_alternative<Type>(*ptrValue->data))
-			{
-				ptrObject = std::get<Type>(*ptrValue->data);
-				return CacheErrorCode::Success;
-			}
+		return m_ptrStorage->addObjects(vtObjects, nPos);
+	}
 
-#ifndef __CONCURRENT__
-			flushItemsToStorage();
+	void getCacheState(size_t& lru, size_t& map)
+	{
+#ifdef __CONCURRENT__
+		std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
 #endif __CONCURRENT__
 
-			return CacheErrorCode::Error;
-		}
-
-		return CacheErrorCode::Error;
+		lru = m_policy.size() + m_nPinned;
+		map = m_mpObjects.size();
 	}
 
-	template<class Type, typename... ArgsType>
-	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, const ArgsType... args)
+	// Bounds the cache by the memory that its objects take up rather than by their count, or goes back to the count it
+	// was created with when 'nBytes' is 0. The budget can be changed at any time; the flush evicts down to a smaller one
+	// right away.
+	void setCapacityBytes(size_t nBytes)
 	{
-		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
-
-		uidObject = ObjectUIDType::createAddressFromVolatilePointer(reinterpret_cast<uintptr_t>(ptrObject.get()));
-
-		std::shared_ptr<Item> ptrItem = std::make_shared<Item>(*uidObject, ptrObject);
+		bool bFlush = false;
 
+		{
 #ifdef __CONCURRENT__
-		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+			std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
 #endif __CONCURRENT__
 
-		if (m_mpObjects.find(*uidObject) != m_mpObjects.end())
-		{
-			std::shared_ptr<Item> ptrItem = m_mpObjects[*uidObject];
-			ptrItem->m_ptrObject = ptrObject;
-			moveToFront(ptrItem);
-		}
-		else
-		{
-			m_mpObjects[*uidObject] = ptrItem;
-			if (!m_ptrHead) 
-			{
-				m_ptrHead = ptrItem;
-				m_ptrTail = ptrItem;
-			}
-			else 
-			{
-				ptrItem->m_ptrNext = m_ptrHead;
-				m_ptrHead->m_ptrPrev = ptrItem;
-				m_ptrHead = ptrItem;
-			}
+			m_nCapacityBytes = nBytes;
+			bFlush = isAbove(FLUSH_HIGH_WATERMARK);
 		}
 
 #ifdef __CONCURRENT__
-		//..
+		if (bFlush)
+		{
+			requestFlush(false);
+		}
 #else
 		flushItemsToStorage();
 #endif __CONCURRENT__
-
-		return CacheErrorCode::Success;
 	}
 
-	template<class Type, typename... ArgsType>
-	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, std::shared_ptr<Type>& ptrCoreObject, const ArgsType... args)
+	// The memory that the resident objects take up, as of their last measurement.
+	size_t getCacheBytes()
 	{
-		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
-
-		ptrCoreObject = ptrObject->data;
-
-		uidObject = ObjectUIDType::createAddressFromVolatilePointer(reinterpret_cast<uintptr_t>(ptrObject.get()));
-
-		std::shared_ptr<Item> ptrItem = std::make_shared<Item>(*uidObject, ptrObject);
-
 #ifdef __CONCURRENT__
-		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+		std::shared_lock<std::shared_mutex> lock_cache(m_mtxCache);
 #endif __CONCURRENT__
 
-		if (m_mpObjects.find(*uidObject) != m_mpObjects.end())
+		return m_nUsedBytes;
+	}
+
+	// The hits and misses per tree level, the root being level 0.
+	void getLevelStats(std::vector<std::pair<size_t, size_t>>& vtStats)
+	{
+		vtStats.clear();
+		for (size_t nLevel = 0; nLevel < STATS_LEVELS; nLevel++)
 		{
-			std::shared_ptr<Item> ptrItem = m_mpObjects[*uidObject];
-			ptrItem->m_ptrObject = ptrObject;
-			moveToFront(ptrItem);
+			vtStats.push_back(std::make_pair(m_vtLevelHits[nLevel].load(), m_vtLevelMisses[nLevel].load()));
 		}
-		else
+
+		while (vtStats.size() > 0 && vtStats.back().first == 0 && vtStats.back().second == 0)
 		{
-			m_mpObjects[*uidObject] = ptrItem;
-			if (!m_ptrHead)
-			{
-				m_ptrHead = ptrItem;
-				m_ptrTail = ptrItem;
-			}
-			else
-			{
-				ptrItem->m_ptrNext = m_ptrHead;
-				m_ptrHead->m_ptrPrev = ptrItem;
-				m_ptrHead = ptrItem;
-			}
+			vtStats.pop_back();
 		}
+	}
 
-#ifdef __CONCURRENT__
-		//..
-#else
-		flushItemsToStorage();
-#endif __CONCURRENT__
+private:
+	inline void add(Item* ptrItem)
+	{
+		ptrItem->m_nRound = m_nRound;
+		ptrItem->m_bFresh = true;
+		measure(ptrItem);
+		m_policy.add(ptrItem);
+	}
 
-		return CacheErrorCode::Success;
+	inline void admit(Item* ptrItem)
+	{
+		ptrItem->m_nRound = m_nRound;
+		measure(ptrItem);
+		ptrItem->m_bMissed = true;
+		m_policy.admit(ptrItem);
 	}
 
-	void getCacheState(size_t& lru, size_t& map)
+	inline void touch(Item* ptrItem)
 	{
-		lru = 0;
-		std::shared_ptr<Item> _ptrItem = m_ptrHead;
-		do
+		ptrItem->m_nRound = m_nRound;
+		ptrItem->m_bFresh = false;
+
+		if (m_nCapacityBytes > 0)
 		{
-			lru++;
-			_ptrItem = _ptrItem->m_ptrNext;
+			measure(ptrItem);
+		}
 
-		} while (_ptrItem != nullptr);
+		updateLevel(ptrItem);
 
-		map = m_mpObjects.size();
+		if (!ptrItem->m_bPinned)
+		{
+			m_policy.touch(ptrItem);
+		}
 	}
 
-private:
-	void moveToTail(std::shared_ptr<Item> tail, std::shared_ptr<Item> nodeToMove) 
+	// The nodes grow and shrink in place, hence the items are measured again whenever they are touched under a byte
+	// budget. An object that someone holds exclusively is in the middle of a change and keeps its previous size.
+	inline void measure(Item* ptrItem)
 	{
-		if (tail == nullptr || nodeToMove == nullptr)
+		if (!ptrItem->m_ptrObject->mutex.try_lock_shared())
 		{
 			return;
 		}
 
-		if (nodeToMove->m_ptrPrev != nullptr)
-		{
-			nodeToMove->m_ptrPrev->m_ptrNext = nodeToMove->m_ptrNext;
-		}
-		else
+		size_t nBytes = ptrItem->m_ptrObject->getMemorySize() + ITEM_SIZE;
+
+		ptrItem->m_ptrObject->mutex.unlock_shared();
+
+		m_nUsedBytes = m_nUsedBytes - ptrItem->m_nBytes + nBytes;
+		if (ptrItem->m_bPinned)
 		{
-			tail = nodeToMove->m_ptrNext;
+			m_nPinnedBytes = m_nPinnedBytes - ptrItem->m_nBytes + nBytes;
 		}
 
-		if (nodeToMove->m_ptrNext != nullptr)
+		ptrItem->m_nBytes = nBytes;
+	}
+
+	inline bool canPin() const
+	{
+		if (m_nCapacityBytes > 0)
 		{
-			nodeToMove->m_ptrNext->m_ptrPrev = nodeToMove->m_ptrPrev;
+			return m_nPinnedBytes < m_nCapacityBytes * PINNED_SHARE / 100;
 		}
 
-		if (tail != nullptr) 
+		return m_nPinned < m_nMaxPinned;
+	}
+
+	// Whether the cache holds more than 'nPercent' of its capacity, by count or by bytes; called under the cache lock.
+	inline bool isAbove(size_t nPercent) const
+	{
+		if (m_nCapacityBytes > 0)
 		{
-			tail->m_ptrNext = nodeToMove;
-			nodeToMove->m_ptrPrev = tail;
-			nodeToMove->m_ptrNext = nullptr;
-			tail = nodeToMove;
+			return m_nUsedBytes > m_nCapacityBytes * nPercent / 100;
 		}
-		else 
+
+		return m_mpObjects.size() > m_nCacheCapacity * nPercent / 100;
+	}
+
+	inline void hit(Item* ptrItem)
+	{
+		countHit(ptrItem->m_ptrObject->level);
+	}
+
+	inline void countHit(uint8_t nLevel)
+	{
+		if (nLevel == ObjectType::UNKNOWN_LEVEL)
 		{
-			tail = nodeToMove;
+			return;
 		}
+
+		m_vtLevelHits[std::min<size_t>(nLevel, STATS_LEVELS - 1)].fetch_add(1, std::memory_order_relaxed);
 	}
 
-	void interchangeWithTail(std::shared_ptr<Item> currentNode) {
-		if (currentNode == nullptr || currentNode == m_ptrTail) 
+	// The tree tags an object with its level whenever it fetches it, which the cache picks up the next time it touches the
+	// item (every operation reorders the nodes it has accessed): a pending miss is counted, and the item is pinned or
+	// unpinned. A pinned item is kept out of the policy altogether, hence it is never picked for eviction.
+	inline void updateLevel(Item* ptrItem)
+	{
+		uint8_t nLevel = ptrItem->m_ptrObject->level;
+		if (nLevel == ObjectType::UNKNOWN_LEVEL)
 		{
 			return;
 		}
 
-		if (currentNode->m_ptrPrev) 
+		m_nLeafLevel = std::max(m_nLeafLevel, nLevel);
+
+		if (ptrItem->m_bMissed)
 		{
-			currentNode->m_ptrPrev->m_ptrNext = currentNode->m_ptrNext;
+			m_vtLevelMisses[std::min<size_t>(nLevel, STATS_LEVELS - 1)].fetch_add(1, std::memory_order_relaxed);
+			ptrItem->m_bMissed = false;
 		}
-		else 
+
+		// The root is pinned regardless of the share, lest the nodes of the level below take up all of it.
+		bool bPinned = nLevel < m_nPinnedLevels && (nLevel == 0 || ptrItem->m_bPinned || canPin());
+		if (bPinned == ptrItem->m_bPinned)
 		{
-			m_ptrHead = currentNode->m_ptrNext;
+			return;
 		}
 
-		if (currentNode->m_ptrNext) 
+		if (bPinned)
 		{
-			currentNode->m_ptrNext->m_ptrPrev = currentNode->m_ptrPrev;
+			m_policy.remove(ptrItem);
+			m_nPinned++;
+			m_nPinnedBytes += ptrItem->m_nBytes;
+		}
+		else
+		{
+			m_nPinned--;
+			m_nPinnedBytes -= ptrItem->m_nBytes;
+			m_policy.add(ptrItem);
 		}
 
-		currentNode->m_ptrPrev = m_ptrTail;
-		currentNode->m_ptrNext = nullptr;
+		ptrItem->m_bPinned = bPinned;
+	}
 
-		m_ptrTail->m_ptrNext = currentNode;
+	// The object is returned rather than its item, as the item may be recycled once the lock is released.
+	inline ObjectTypePtr findObject(const ObjectUIDType& uidObject)
+	{
+#ifdef __CONCURRENT__
+		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache); // std::unique_lock due to the policy's update! is there any better way?
+#endif __CONCURRENT__
+
+		auto it = m_mpObjects.find(uidObject);
+		if (it == m_mpObjects.end())
+		{
+			return nullptr;
+		}
 
-		m_ptrTail = currentNode;
+		hit((*it).second);
+		touch((*it).second);
+		return (*it).second->m_ptrObject;
 	}
 
-	inline void moveToFront(std::shared_ptr<Item> ptrItem)
+	inline void addObject(const ObjectUIDType& uidObject, std::shared_ptr<ObjectType> ptrObject)
 	{
-		if (ptrItem == m_ptrHead)
+		bool bFlush = false;
+		bool bWait = false;
+
 		{
-			return;
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = m_mpObjects.find(uidObject);
+			if (it != m_mpObjects.end())
+			{
+				(*it).second->m_ptrObject = ptrObject;
+				measure((*it).second);
+				touch((*it).second);
+			}
+			else
+			{
+				Item* ptrItem = m_poolItems.acquire();
+				ptrItem->init(uidObject, ptrObject);
+				m_mpObjects[uidObject] = ptrItem;
+				add(ptrItem);
+			}
+
+			bFlush = isAbove(FLUSH_HIGH_WATERMARK);
+			bWait = isAbove(FLUSH_HARD_LIMIT);
 		}
 
-		if (ptrItem->m_ptrPrev) 
+#ifdef __CONCURRENT__
+		if (bFlush)
 		{
-			ptrItem->m_ptrPrev->m_ptrNext = ptrItem->m_ptrNext;
+			requestFlush(bWait);
 		}
+#else
+		flushItemsToStorage();
+#endif __CONCURRENT__
+	}
+
+	// The miss path of getObject. The directory is looked up once more, and before the storage is released: the flush takes
+	// the storage first, and an object that it has picked meanwhile is thus either pending or put back by then, rather than
+	// read from its former place on the storage.
+	ObjectTypePtr loadObject(const ObjectUIDType& uidObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		ObjectUIDType _uidUpdated = uidObject;
+
+		bool bFlush = false;
+		bool bWait = false;
 
-		if (ptrItem->m_ptrNext) 
 		{
-			ptrItem->m_ptrNext->m_ptrPrev = ptrItem->m_ptrPrev;
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage); // TODO: requesting the same key?
+#endif __CONCURRENT__
+
+			auto it = m_mpUpdatedUIDs.find(uidObject);
+			if (it != m_mpUpdatedUIDs.end())
+			{
+#ifdef __CONCURRENT__
+				std::optional< ObjectUIDType >& _condition = (*it).second.first;
+				cv.wait(lock_storage, [&_condition] { return _condition != std::nullopt; });
+#endif __CONCURRENT__
+
+				uidUpdated = m_mpUpdatedUIDs[uidObject].first;
+
+				assert(uidUpdated != std::nullopt);
+
+				m_mpUpdatedUIDs.erase(uidObject);	// Applied.
+				_uidUpdated = *uidUpdated;
+			}
+			else
+			{
+				ObjectTypePtr ptrObject = findObject(uidObject);
+				if (ptrObject != nullptr)
+				{
+					return ptrObject;
+				}
+			}
 		}
 
-		if (ptrItem == m_ptrTail) 
+		std::shared_ptr<ObjectType> ptrValue = m_ptrStorage->getObject(_uidUpdated);
+		if (ptrValue == nullptr)
 		{
-			m_ptrTail = ptrItem->m_ptrPrev;
+			return nullptr;
 		}
 
-		ptrItem->m_ptrPrev = nullptr;
-		ptrItem->m_ptrNext = m_ptrHead;
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
+#endif __CONCURRENT__
 
-		if (m_ptrHead) 
+			auto it = m_mpObjects.find(_uidUpdated);
+			if (it != m_mpObjects.end())
+			{
+				// Loaded by another thread in the meantime.
+				touch((*it).second);
+				return (*it).second->m_ptrObject;
+			}
+
+			Item* ptrItem = m_poolItems.acquire();
+			ptrItem->init(_uidUpdated, ptrValue);
+			m_mpObjects[_uidUpdated] = ptrItem;
+			admit(ptrItem);
+
+			bFlush = isAbove(FLUSH_HIGH_WATERMARK);
+			bWait = isAbove(FLUSH_HARD_LIMIT);
+		}
+
+#ifdef __CONCURRENT__
+		if (bFlush)
 		{
-			m_ptrHead->m_ptrPrev = ptrItem;
+			requestFlush(bWait);
 		}
-		m_ptrHead = ptrItem;
+#else
+		flushItemsToStorage();
+#endif __CONCURRENT__
+
+		return ptrValue;
 	}
 
-	inline void removeFromLRU(std::shared_ptr<Item> ptrItem)
+	// An item is in use while anyone else holds its object or its node, or has it locked. The ones created since the
+	// previous round and not touched yet are passed over as well: an operation may not hold a node that it has just
+	// created (e.g. the new sibling of a split) until it reorders it, which only the plain LRU order would otherwise keep
+	// from being evicted.
+	inline bool isEvictable(Item* ptrItem)
 	{
-		if (ptrItem->m_ptrPrev != nullptr) 
+		if (ptrItem->m_bFresh && ptrItem->m_nRound + 1 >= m_nRound)
 		{
-			ptrItem->m_ptrPrev->m_ptrNext = ptrItem->m_ptrNext;
+			return false;
 		}
-		else 
+
+		if (ptrItem->m_ptrObject.use_count() > 1)
 		{
-			m_ptrHead = ptrItem->m_ptrNext;
-			if (m_ptrHead != nullptr)
-			{
-				m_ptrHead->m_ptrPrev = nullptr;
-			}
+			return false;
 		}
 
-		if (ptrItem->m_ptrNext != nullptr) 
+		if (std::visit([](const auto& ptrCoreObject) { return ptrCoreObject.use_count() > 1; }, *ptrItem->m_ptrObject->data))
 		{
-			ptrItem->m_ptrNext->m_ptrPrev = ptrItem->m_ptrPrev;
+			return false;
 		}
-		else 
+
+		if (!ptrItem->m_ptrObject->mutex.try_lock())
 		{
-			m_ptrTail = ptrItem->m_ptrPrev;
-			if (m_ptrTail != nullptr)
-			{
-				m_ptrTail->m_ptrNext = nullptr;
-			}
+			return false;
 		}
+
+		ptrItem->m_ptrObject->mutex.unlock();
+
+		// See validateSwizzled.
+		ptrItem->m_ptrObject->evicted = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (ptrItem->m_ptrObject.use_count() > 1)
+		{
+			ptrItem->m_ptrObject->evicted = false;
+			return false;
+		}
+
+		return true;
 	}
 
-	inline void flushItemsToStorage()
+	inline bool isLeaf(Item* ptrItem) const
+	{
+		uint8_t nLevel = ptrItem->m_ptrObject->level;
+		return nLevel != ObjectType::UNKNOWN_LEVEL && nLevel >= m_nLeafLevel;
+	}
+
+	// Evicts a batch, as large as it takes to get the cache down to the low watermark (to the capacity when the flush is
+	// synchronous) but no larger than FLUSH_MAX_BATCH, and returns the number of objects that it has taken out.
+	inline size_t flushItemsToStorage()
 	{
-#ifdef __CONCURRENT__
 		std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>> vtObjects;
+		std::vector<Item*> vtVictims;
 
+#ifdef __CONCURRENT__
+		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
 		std::unique_lock<std::shared_mutex> lock_cache(m_mtxCache);
 
-		if (m_mpObjects.size() < m_nCacheCapacity)
-			return;
+		const size_t nTarget = FLUSH_LOW_WATERMARK;
+#else
+		const size_t nTarget = 100;
+#endif __CONCURRENT__
 
-		size_t nFlushCount = m_mpObjects.size() - m_nCacheCapacity;
+		if (!isAbove(nTarget))
+			return 0;
 
-		if (nFlushCount > FLUSH_COUNT)
-			nFlushCount = FLUSH_COUNT;
+		nextRound();
 
-		for (size_t idx = 0; idx < nFlushCount; idx++)
+		// Leaves first: the index nodes above the resident leaves could not be written before them anyway.
+		while (vtVictims.size() < FLUSH_MAX_BATCH && isAbove(nTarget))
 		{
-			if (m_ptrTail->m_ptrObject.use_count() > 1)
+			Item* ptrItem = m_policy.victim([this](Item* ptrItem) { return isLeaf(ptrItem) && isEvictable(ptrItem); });
+			if (ptrItem == nullptr)
 			{
-				/* Info: 
-				 * Should proceed with the preceeding one?
-				 * But since each operation reorders the items at the end, therefore, the prceeding items would be in use as well!
-				 */
-				break; 
+				ptrItem = m_policy.victim([this](Item* ptrItem) { return isEvictable(ptrItem); });
 			}
 
-			// Check if the object is in use
-			if (!m_ptrTail->m_ptrObject->mutex.try_lock())
+			if (ptrItem == nullptr)
 			{
-				/* Info:
-				 * Should proceed with the preceeding one?
-				 * But since each operation reorders the items at the end, therefore, the prceeding items would be in use as well!
-				 */
 				break;
 			}
-			else
-			{
-				m_ptrTail->m_ptrObject->mutex.unlock();
-			}
-
-
-			std::shared_ptr<Item> ptrItemToFlush = m_ptrTail;
-
-			vtObjects.push_back(std::make_pair(ptrItemToFlush->m_uidSelf, std::make_pair(std::nullopt, ptrItemToFlush->m_ptrObject)));
 
-			m_mpObjects.erase(ptrItemToFlush->m_uidSelf);
+			vtObjects.push_back(std::make_pair(ptrItem->m_uidSelf, std::make_pair(std::nullopt, ptrItem->m_ptrObject)));
+			vtVictims.push_back(ptrItem);
 
-			m_ptrTail = ptrItemToFlush->m_ptrPrev;
-
-			ptrItemToFlush->m_ptrPrev = nullptr;
-			ptrItemToFlush->m_ptrNext = nullptr;
-
-			if (m_ptrTail)
-			{
-				m_ptrTail->m_ptrNext = nullptr;
-			}
-			else
-			{
-				m_ptrHead = nullptr;
-			}
+			m_mpObjects.erase(ptrItem->m_uidSelf);
+			m_nUsedBytes -= ptrItem->m_nBytes;
 		}
 
-		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
+		size_t nVictims = vtVictims.size();
+		if (nVictims == 0)
+			return 0;
 
+#ifdef __CONCURRENT__
 		lock_cache.unlock();
+#endif __CONCURRENT__
 
 		if (m_mpUpdatedUIDs.size() > 0)
 		{
@@ -675,109 +924,172 @@ private:
 
 		m_ptrCallback->prepareFlush(vtObjects, nPos, m_ptrStorage->getBlockSize(), m_ptrStorage->getMediaType());
 
-		auto it = vtObjects.begin();
-		while (it != vtObjects.end())
+		// prepareFlush drops the clean nodes, which stay where they are on the storage, and leaves the ones that still refer
+		// to a child in the cache without a uid; the latter go back into the cache. The policy learns the uid that each of
+		// the others is to be loaded back under.
 		{
-			if ((*it).second.second.use_count() != 1)
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> re_lock_cache(m_mtxCache);
+#endif __CONCURRENT__
+
+			std::unordered_map<ObjectUIDType, std::optional<ObjectUIDType>> mpStoredUIDs;
+			for (auto it = vtObjects.begin(); it != vtObjects.end(); it++)
 			{
-				throw new std::exception("should not occur!");
+				mpStoredUIDs[(*it).first] = (*it).second.first;
 			}
 
-			if (m_mpUpdatedUIDs.find((*it).first) != m_mpUpdatedUIDs.end())
+			for (auto it = vtVictims.begin(); it != vtVictims.end(); it++)
 			{
-				throw new std::exception("should not occur!");
+				auto itStored = mpStoredUIDs.find((*it)->m_uidSelf);
+				if (itStored == mpStoredUIDs.end())
+				{
+					m_policy.evicted(*it, (*it)->m_uidSelf);
+					m_poolItems.release(*it);
+				}
+				else if ((*itStored).second == std::nullopt)
+				{
+					(*it)->m_ptrObject->evicted = false;
+					m_mpObjects[(*it)->m_uidSelf] = *it;
+					m_nUsedBytes += (*it)->m_nBytes;
+					m_policy.restore(*it);
+				}
+				else
+				{
+					m_policy.evicted(*it, *(*itStored).second);
+					m_poolItems.release(*it);
+				}
 			}
-			else
+		}
+
+		vtVictims.clear();
+
+		vtObjects.erase(std::remove_if(vtObjects.begin(), vtObjects.end(), [](const auto& prObject) { return prObject.second.first == std::nullopt; }), vtObjects.end());
+
+		// A reader may hold a victim for a moment here, until it sees it marked through a swizzled reference; hence its use
+		// count is not checked.
+		auto it = vtObjects.begin();
+		while (it != vtObjects.end())
+		{
+			if (m_mpUpdatedUIDs.find((*it).first) != m_mpUpdatedUIDs.end())
 			{
-				m_mpUpdatedUIDs[(*it).first] = std::make_pair(std::nullopt, (*it).second.second);
+				throw new std::exception("should not occur!");
 			}
 
+#ifdef __CONCURRENT__
+			m_mpUpdatedUIDs[(*it).first] = std::make_pair(std::nullopt, (*it).second.second);
+#else
+			m_mpUpdatedUIDs[(*it).first] = std::make_pair((*it).second.first, (*it).second.second);
+#endif __CONCURRENT__
+
 			it++;
 		}
 
+		if (vtObjects.size() == 0)
+			return nVictims;
+
+#ifdef __CONCURRENT__
 		lock_storage.unlock();
-		
+#endif __CONCURRENT__
+
 		m_ptrStorage->addObjects(vtObjects, nPos);
 
+#ifdef __CONCURRENT__
+		lock_storage.lock();
+
 		it = vtObjects.begin();
 		while (it != vtObjects.end())
 		{
-			if (m_mpUpdatedUIDs.find((*it).first) != m_mpUpdatedUIDs.end())
-			{
-				m_mpUpdatedUIDs[(*it).first] = std::make_pair((*it).second.first, (*it).second.second);
-			}
-			else
-			{
-				throw new std::exception("should not occur!");
-			}
-
+			m_mpUpdatedUIDs[(*it).first].first = (*it).second.first;
 			it++;
 		}
 
+		lock_storage.unlock();
+
 		cv.notify_all();
+#endif __CONCURRENT__
 
-		vtObjects.clear();
-#else
-		while (m_mpObjects.size() > m_nCacheCapacity)
-		{
-			if (m_ptrTail->m_ptrObject.use_count() > 1)
-			{
-				/* Info:
-				 * Should proceed with the preceeding one?
-				 * But since each operation reorders the items at the end, therefore, the prceeding items would be in use as well!
-				 */
-				break;
-			}
+		return nVictims;
+	}
 
-			if (m_ptrTail->m_ptrObject->dirty)
-			{
-				if (m_mpUpdatedUIDs.size() > 0)
-				{
-					m_ptrCallback->applyExistingUpdates(m_ptrTail->m_ptrObject, m_mpUpdatedUIDs);
-				}
+	// The flush runs in rounds, and isEvictable passes over the items touched during the current or the previous one. A
+	// round lasts FLUSH_ROUND_MS at least however often the flush runs, lest an operation that has yet to reorder a node
+	// it has just created lose it to a quick succession of batches; the synchronous flush has no such operations.
+	inline void nextRound()
+	{
+#ifdef __CONCURRENT__
+		std::chrono::steady_clock::time_point tmNow = std::chrono::steady_clock::now();
+		if (tmNow - m_tmRound < std::chrono::milliseconds(FLUSH_ROUND_MS))
+		{
+			return;
+		}
 
-				ObjectUIDType uidUpdated;
-				if (m_ptrStorage->addObject(m_ptrTail->m_uidSelf, m_ptrTail->m_ptrObject, uidUpdated) != CacheErrorCode::Success)
-				{
-					throw new std::exception("should not occur!");
-				}
+		m_tmRound = tmNow;
+#endif __CONCURRENT__
 
-				if (m_mpUpdatedUIDs.find(m_ptrTail->m_uidSelf) != m_mpUpdatedUIDs.end())
-				{
-					throw new std::exception("should not occur!");
-				}
+		m_nRound++;
+	}
 
-				m_mpUpdatedUIDs[m_ptrTail->m_uidSelf] = std::make_pair(uidUpdated, m_ptrTail->m_ptrObject);
-			}
+#ifdef __CONCURRENT__
+	// Wakes the flush thread, and blocks the writer that has taken the cache past the hard limit until the next batch is
+	// written (or a round has passed). The writer does not wait while the batches free nothing, as it may itself hold the
+	// nodes that are left, e.g. a whole level of a batch search.
+	inline void requestFlush(bool bWait)
+	{
+		std::unique_lock<std::mutex> lock_flush(m_mtxFlush);
 
-			m_mpObjects.erase(m_ptrTail->m_uidSelf);
+		if (!m_bFlushPending)
+		{
+			m_bFlushPending = true;
+			m_cvFlush.notify_one();
+		}
 
-			std::shared_ptr<Item> ptrTemp = m_ptrTail;
+		if (bWait && !m_bFlushStalled)
+		{
+			size_t nBatches = m_nFlushBatches;
+			m_cvFlushed.wait_for(lock_flush, std::chrono::milliseconds(FLUSH_ROUND_MS), [this, nBatches] { return m_bStop || m_nFlushBatches != nBatches; });
+		}
+	}
 
-			m_ptrTail = m_ptrTail->m_ptrPrev;
+	// Sleeps until a writer requests a flush, then evicts batch after batch until the cache is down to the low watermark.
+	// A batch that frees nothing means that the remaining items are in use or were touched too recently; it is retried
+	// once the round is over.
+	static void handlerCacheFlush(SelfType* ptrSelf)
+	{
+		std::unique_lock<std::mutex> lock_flush(ptrSelf->m_mtxFlush);
 
-			if (m_ptrTail)
+		while (!ptrSelf->m_bStop)
+		{
+			if (!ptrSelf->m_bFlushPending)
 			{
-				m_ptrTail->m_ptrNext = nullptr;
+				ptrSelf->m_cvFlush.wait(lock_flush, [ptrSelf] { return ptrSelf->m_bStop || ptrSelf->m_bFlushPending; });
+				continue;
 			}
-			else
+
+			lock_flush.unlock();
+
+			size_t nFlushed = ptrSelf->flushItemsToStorage();
+
+			bool bPending = false;
 			{
-				m_ptrHead = nullptr;
+				std::shared_lock<std::shared_mutex> lock_cache(ptrSelf->m_mtxCache);
+				bPending = ptrSelf->isAbove(FLUSH_LOW_WATERMARK);
 			}
-		}
-#endif __CONCURRENT__
-	}
 
-#ifdef __CONCURRENT__
-	static void handlerCacheFlush(SelfType* ptrSelf)
-	{
-		do
-		{
-			ptrSelf->flushItemsToStorage();
+			lock_flush.lock();
 
-			std::this_thread::sleep_for(100ms);
+			ptrSelf->m_nFlushBatches++;
+			ptrSelf->m_bFlushStalled = (nFlushed == 0);
+			ptrSelf->m_cvFlushed.notify_all();
 
-		} while (!ptrSelf->m_bStop);
+			if (!bPending)
+			{
+				ptrSelf->m_bFlushPending = false;
+			}
+			else if (nFlushed == 0)
+			{
+				ptrSelf->m_cvFlush.wait_for(lock_flush, std::chrono::milliseconds(FLUSH_ROUND_MS), [ptrSelf] { return ptrSelf->m_bStop; });
+			}
+		}
 	}
 #endif __CONCURRENT__
 
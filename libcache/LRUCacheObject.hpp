@@ -6,11 +6,13 @@
 #include <thread>
 #include <variant>
 #include <typeinfo>
+#include <atomic>
 
 #include <iostream>
 #include <fstream>
 
 #include "ErrorCodes.h"
+#include "VersionedSharedMutex.hpp"
 
 template <typename T>
 std::shared_ptr<T> cloneSharedPtr(const std::shared_ptr<T>& source) {
@@ -38,15 +40,30 @@ private:
 
 	
 
+public:
+	static constexpr uint8_t UNKNOWN_LEVEL = 0xFF;
+
+private:
+	static constexpr size_t CONTROL_BLOCK_SIZE = 2 * sizeof(void*) + 2 * sizeof(long);
+
 public:
 	bool dirty;
 	CoreTypesWrapperPtr data;
-	mutable std::shared_mutex mutex;
+	mutable VersionedSharedMutex mutex;
+
+	// The depth in the tree (the root being 0) at which the tree-aware tree last fetched the object; the cache pins the
+	// upper levels and prefers evicting the deepest one.
+	uint8_t level;
+
+	// Set by the cache once the object is no longer resident; the tree's swizzled references to it are then stale.
+	std::atomic<bool> evicted;
 
 public:
 	template<class Type>
 	LRUCacheObject(std::shared_ptr<Type> ptrCoreObject)
 		: dirty(true)
+		, level(UNKNOWN_LEVEL)
+		, evicted(false)
 	{
 		data = std::make_shared<CoreTypesWrapper>(ptrCoreObject);
 	}
@@ -54,22 +71,36 @@ public:
 	//template <typename Type>
 	LRUCacheObject(const LRUCacheObject& source)
 		: dirty(true)
+		, level(source.level)
+		, evicted(false)
 	{
 		data = std::make_shared<CoreTypesWrapper>(cloneVariant(*source.data));
 	}
 
 	LRUCacheObject(std::fstream& is)
 		: dirty(true)
+		, level(UNKNOWN_LEVEL)
+		, evicted(false)
 	{
 		CoreTypesMarshaller::template deserialize<CoreTypesWrapper, CoreTypes...>(is, data);
 	}
 
 	LRUCacheObject(const char* szBuffer)
 		: dirty(true)
+		, level(UNKNOWN_LEVEL)
+		, evicted(false)
 	{
 		CoreTypesMarshaller::template deserialize<CoreTypesWrapper, CoreTypes...>(szBuffer, data);
 	}
 
+	// An estimate of the memory that the object takes up: the node's own size (that of its entries) plus the node, the
+	// object and the variant themselves, and the control blocks of the shared pointers to them.
+	inline size_t getMemorySize()
+	{
+		return sizeof(LRUCacheObject) + sizeof(CoreTypesWrapper) + 3 * CONTROL_BLOCK_SIZE
+			+ std::visit([](const auto& ptrCoreObject) { return sizeof(*ptrCoreObject) + ptrCoreObject->getSize(); }, *data);
+	}
+
 	inline void serialize(std::fstream& os, uint8_t& uidObjectType, size_t& nBufferSize)
 	{
 		CoreTypesMarshaller::template serialize<CoreTypes...>(os, *data, uidObjectType, nBufferSize);
@@ -6,6 +6,8 @@
 #include <thread>
 #include <variant>
 #include <typeinfo>
+#include <vector>
+#include <atomic>
 
 #include "CacheErrorCodes.h"
 #include "IFlushCallback.h"
@@ -19,13 +21,33 @@ public:
 	typedef ValueType<ValueCoreTypes...>* ObjectTypePtr;
 	typedef std::tuple<ValueCoreTypes...> ObjectCoreTypes;
 
+private:
+	// Optimistic readers hold no lock, so a removed object is only retired; it is deleted once every reader that might
+	// have reached it has left. Readers register with the epoch current on entry, and the epoch advances (deleting what
+	// was retired two epochs back) only once the readers of the previous one have all left.
+	std::atomic<size_t> m_nEpoch;
+	std::atomic<size_t> m_vtReaders[2];
+
+	std::mutex m_mtxRetired;
+	std::vector<ObjectTypePtr> m_vtRetired[2];
+
 public:
 	~NoCache()
 	{
+		for (int idx = 0; idx < 2; idx++)
+		{
+			for (auto it = m_vtRetired[idx].begin(); it != m_vtRetired[idx].end(); it++)
+			{
+				delete *it;
+			}
+		}
 	}
 
 	NoCache()
+		: m_nEpoch(0)
 	{
+		m_vtReaders[0] = 0;
+		m_vtReaders[1] = 0;
 	}
 
 	template <typename... InitArgs>
@@ -37,17 +59,74 @@ public:
 	CacheErrorCode remove(ObjectUIDType objKey)
 	{
 		ObjectTypePtr ptrValue = reinterpret_cast<ObjectTypePtr>(objKey);
-		delete ptrValue;
+
+		std::unique_lock<std::mutex> lock(m_mtxRetired);
+
+		size_t nEpoch = m_nEpoch.load();
+		if (m_vtReaders[(nEpoch + 1) & 1].load() == 0)
+		{
+			std::vector<ObjectTypePtr>& vtRetired = m_vtRetired[(nEpoch + 1) & 1];
+			for (auto it = vtRetired.begin(); it != vtRetired.end(); it++)
+			{
+				delete *it;
+			}
+
+			vtRetired.clear();
+			m_nEpoch.store(++nEpoch);
+		}
+
+		m_vtRetired[nEpoch & 1].push_back(ptrValue);
 
 		return CacheErrorCode::KeyDoesNotExist;
 	}
 
+	// Brackets a lock-free read; the objects reached in between are not deleted until leaveEpoch.
+	inline size_t enterEpoch()
+	{
+		do
+		{
+			size_t nEpoch = m_nEpoch.load();
+			m_vtReaders[nEpoch & 1].fetch_add(1);
+
+			// Registering with an epoch that has meanwhile been left behind would not hold off the deletes.
+			if (m_nEpoch.load() == nEpoch)
+			{
+				return nEpoch & 1;
+			}
+
+			m_vtReaders[nEpoch & 1].fetch_sub(1);
+		} while (true);
+	}
+
+	inline void leaveEpoch(size_t nSlot)
+	{
+		m_vtReaders[nSlot].fetch_sub(1);
+	}
+
 	CacheErrorCode getObject(ObjectUIDType objKey, ObjectTypePtr& ptrObject)
 	{
 		ptrObject = reinterpret_cast<ObjectTypePtr>(objKey);
 		return CacheErrorCode::Success;
 	}
 
+	CacheErrorCode getObjects(const std::vector<ObjectUIDType>& vtUIDs, std::vector<ObjectTypePtr>& vtObjects)
+	{
+		vtObjects.resize(vtUIDs.size());
+		for (size_t nIdx = 0; nIdx < vtUIDs.size(); nIdx++)
+		{
+			vtObjects[nIdx] = reinterpret_cast<ObjectTypePtr>(vtUIDs[nIdx]);
+		}
+
+		return CacheErrorCode::Success;
+	}
+
+	// Every object is resident in this cache, hence it is the same as getObject.
+	CacheErrorCode peekObject(ObjectUIDType objKey, ObjectTypePtr& ptrObject)
+	{
+		ptrObject = reinterpret_cast<ObjectTypePtr>(objKey);
+		return CacheErrorCode::Success;
+	}
+
 	template <typename Type>
 	CacheErrorCode getObjectOfType(ObjectUIDType objKey, Type& ptrObject)
 	{
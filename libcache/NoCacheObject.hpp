@@ -8,6 +8,7 @@
 #include <typeinfo>
 
 #include "ErrorCodes.h"
+#include "VersionedSharedMutex.hpp"
 
 template <typename... ValueCoreTypes>
 class NoCacheObject
@@ -20,7 +21,7 @@ public:
 
 public:
 	CacheValueTypePtr data;
-	mutable std::shared_mutex mutex;
+	mutable VersionedSharedMutex mutex;
 
 public:
 	NoCacheObject(CacheValueTypePtr ptrValue)
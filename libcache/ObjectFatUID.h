@@ -82,9 +82,31 @@ public:
 		return key;
 	}
 
+	// Compares the fields in use rather than the raw NodeUID, as the padding that follows m_nMediaType is not
+	// guaranteed to survive a copy.
+	static bool isEqual(const NodeUID& lhs, const NodeUID& rhs)
+	{
+		if (lhs.m_nMediaType != rhs.m_nMediaType)
+		{
+			return false;
+		}
+
+		switch (lhs.m_nMediaType)
+		{
+		case Volatile:
+		case DRAM:
+			return lhs.FATPOINTER.m_ptrVolatile == rhs.FATPOINTER.m_ptrVolatile;
+		case File:
+			return lhs.FATPOINTER.m_ptrFile.m_nOffset == rhs.FATPOINTER.m_ptrFile.m_nOffset
+				&& lhs.FATPOINTER.m_ptrFile.m_nSize == rhs.FATPOINTER.m_ptrFile.m_nSize;
+		default:
+			return memcmp(&lhs.FATPOINTER, &rhs.FATPOINTER, sizeof(lhs.FATPOINTER)) == 0;
+		}
+	}
+
 	bool operator==(const ObjectFatUID& rhs) const 
 	{
-		return memcmp(&m_uid, &rhs.m_uid, sizeof(NodeUID)) == 0;
+		return isEqual(m_uid, rhs.m_uid);
 	}
 
 	bool operator <(const ObjectFatUID& rhs) const
@@ -109,7 +131,7 @@ public:
 	public:
 		bool operator()(const ObjectFatUID& lhs, const ObjectFatUID& rhs) const 
 		{
-			return memcmp(&lhs.m_uid, &rhs.m_uid, sizeof(NodeUID)) == 0;
+			return isEqual(lhs.m_uid, rhs.m_uid);
 		}
 	};
 
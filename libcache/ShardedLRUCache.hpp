@@ -0,0 +1,852 @@
+#pragma once
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <syncstream>
+#include <thread>
+#include <variant>
+#include <typeinfo>
+#include <unordered_map>
+#include <queue>
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <atomic>
+#include <tuple>
+
+#include "ErrorCodes.h"
+#include "IFlushCallback.h"
+#include "VariadicNthType.h"
+
+#define __CONCURRENT__
+//#define __TREE_AWARE_CACHE__
+
+#define FLUSH_COUNT 100
+
+// Same as LRUCache, but the directory and the LRU list are split into SHARDS slices by the hash of the uid, each with its
+// own lock, so that accesses to different objects (cache hits included, as they have to reorder the list) do not contend.
+// Eviction, however, has to stay globally ordered: an index node can only be written once its children have been, which
+// the LRU order guarantees as a parent is always touched after its children. Every touch therefore stamps the item from a
+// global clock, and the flush thread evicts the oldest items across the tails of all the shards, just as LRUCache would.
+template <typename ICallback, typename StorageType, size_t SHARDS = 8>
+class ShardedLRUCache : public ICallback
+{
+	typedef ShardedLRUCache<ICallback, StorageType, SHARDS> SelfType;
+
+public:
+	typedef StorageType::ObjectUIDType ObjectUIDType;
+	typedef StorageType::ObjectType ObjectType;
+	typedef std::shared_ptr<ObjectType> ObjectTypePtr;
+
+	// The tree may keep swizzled references to the resident children only if the cache marks the objects it evicts.
+	static constexpr bool SWIZZLED_CHILDREN = false;
+
+private:
+	struct Item
+	{
+	public:
+		ObjectUIDType m_uidSelf;
+		ObjectTypePtr m_ptrObject;
+		std::shared_ptr<Item> m_ptrPrev;
+		std::shared_ptr<Item> m_ptrNext;
+
+		// The time of the last access, taken from the global clock while the item's shard is locked.
+		uint64_t m_nTick;
+
+		Item(const ObjectUIDType& key, const ObjectTypePtr ptrObject)
+			: m_ptrNext(nullptr)
+			, m_ptrPrev(nullptr)
+			, m_nTick(0)
+		{
+			m_uidSelf = key;
+			m_ptrObject = ptrObject;
+		}
+
+		~Item()
+		{
+			m_ptrPrev = nullptr;
+			m_ptrNext = nullptr;
+			m_ptrObject = nullptr;
+		}
+	};
+
+	// Aligned to a cache line so that the locks of the neighbouring shards do not share one.
+	struct alignas(64) Shard
+	{
+	public:
+		std::shared_ptr<Item> m_ptrHead;
+		std::shared_ptr<Item> m_ptrTail;
+
+		std::unordered_map<ObjectUIDType, std::shared_ptr<Item>> m_mpObjects;
+
+#ifdef __CONCURRENT__
+		mutable std::shared_mutex m_mtxCache;
+#endif __CONCURRENT__
+
+		Shard()
+			: m_ptrHead(nullptr)
+			, m_ptrTail(nullptr)
+		{
+		}
+
+		inline void pushToFront(std::shared_ptr<Item> ptrItem, uint64_t nTick)
+		{
+			ptrItem->m_nTick = nTick;
+
+			if (!m_ptrHead)
+			{
+				m_ptrHead = ptrItem;
+				m_ptrTail = ptrItem;
+			}
+			else
+			{
+				ptrItem->m_ptrNext = m_ptrHead;
+				m_ptrHead->m_ptrPrev = ptrItem;
+				m_ptrHead = ptrItem;
+			}
+		}
+
+		inline void moveToFront(std::shared_ptr<Item> ptrItem, uint64_t nTick)
+		{
+			ptrItem->m_nTick = nTick;
+
+			if (ptrItem == m_ptrHead)
+			{
+				return;
+			}
+
+			if (ptrItem->m_ptrPrev)
+			{
+				ptrItem->m_ptrPrev->m_ptrNext = ptrItem->m_ptrNext;
+			}
+
+			if (ptrItem->m_ptrNext)
+			{
+				ptrItem->m_ptrNext->m_ptrPrev = ptrItem->m_ptrPrev;
+			}
+
+			if (ptrItem == m_ptrTail)
+			{
+				m_ptrTail = ptrItem->m_ptrPrev;
+			}
+
+			ptrItem->m_ptrPrev = nullptr;
+			ptrItem->m_ptrNext = m_ptrHead;
+
+			if (m_ptrHead)
+			{
+				m_ptrHead->m_ptrPrev = ptrItem;
+			}
+			m_ptrHead = ptrItem;
+		}
+
+		inline void removeFromLRU(std::shared_ptr<Item> ptrItem)
+		{
+			if (ptrItem->m_ptrPrev != nullptr)
+			{
+				ptrItem->m_ptrPrev->m_ptrNext = ptrItem->m_ptrNext;
+			}
+			else
+			{
+				m_ptrHead = ptrItem->m_ptrNext;
+				if (m_ptrHead != nullptr)
+				{
+					m_ptrHead->m_ptrPrev = nullptr;
+				}
+			}
+
+			if (ptrItem->m_ptrNext != nullptr)
+			{
+				ptrItem->m_ptrNext->m_ptrPrev = ptrItem->m_ptrPrev;
+			}
+			else
+			{
+				m_ptrTail = ptrItem->m_ptrPrev;
+				if (m_ptrTail != nullptr)
+				{
+					m_ptrTail->m_ptrNext = nullptr;
+				}
+			}
+
+			ptrItem->m_ptrPrev = nullptr;
+			ptrItem->m_ptrNext = nullptr;
+		}
+
+		inline std::shared_ptr<Item> popTail()
+		{
+			std::shared_ptr<Item> ptrItem = m_ptrTail;
+
+			m_ptrTail = ptrItem->m_ptrPrev;
+
+			ptrItem->m_ptrPrev = nullptr;
+			ptrItem->m_ptrNext = nullptr;
+
+			if (m_ptrTail)
+			{
+				m_ptrTail->m_ptrNext = nullptr;
+			}
+			else
+			{
+				m_ptrHead = nullptr;
+			}
+
+			return ptrItem;
+		}
+	};
+
+	ICallback* m_ptrCallback;
+
+	std::unique_ptr<StorageType> m_ptrStorage;
+
+	size_t m_nCacheCapacity;
+	std::array<Shard, SHARDS> m_vtShards;
+
+	std::atomic<uint64_t> m_nClock;
+
+	std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, ObjectTypePtr>> m_mpUpdatedUIDs;
+
+#ifdef __CONCURRENT__
+	bool m_bStop;
+
+	std::thread m_threadCacheFlush;
+
+	std::condition_variable_any cv;
+
+	mutable std::shared_mutex m_mtxStorage;
+#endif __CONCURRENT__
+
+public:
+	~ShardedLRUCache()
+	{
+#ifdef __CONCURRENT__
+		m_bStop = true;
+		m_threadCacheFlush.join();
+#endif __CONCURRENT__
+
+		for (size_t nShard = 0; nShard < SHARDS; nShard++)
+		{
+			m_vtShards[nShard].m_ptrHead = nullptr;
+			m_vtShards[nShard].m_ptrTail = nullptr;
+			m_vtShards[nShard].m_mpObjects.clear();
+		}
+
+		m_ptrStorage = nullptr;
+	}
+
+	template <typename... StorageArgs>
+	ShardedLRUCache(size_t nCapacity, StorageArgs... args)
+		: m_nCacheCapacity(nCapacity)
+		, m_nClock(0)
+	{
+		m_ptrStorage = std::make_unique<StorageType>(args...);
+
+#ifdef __CONCURRENT__
+		m_bStop = false;
+		m_threadCacheFlush = std::thread(handlerCacheFlush, this);
+#endif __CONCURRENT__
+	}
+
+	template <typename... InitArgs>
+	CacheErrorCode init(ICallback* ptrCallback, InitArgs... args)
+	{
+		m_ptrCallback = ptrCallback;
+		return m_ptrStorage->init(this/*getNthElement<0>(args...)*/);
+	}
+
+	CacheErrorCode remove(const ObjectUIDType& uidObject)
+	{
+		CacheErrorCode errCode = CacheErrorCode::Error;
+
+		Shard& shard = getShard(uidObject);
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = shard.m_mpObjects.find(uidObject);
+			if (it != shard.m_mpObjects.end())
+			{
+				shard.removeFromLRU((*it).second);
+				shard.m_mpObjects.erase(it);
+				errCode = CacheErrorCode::Success;
+			}
+		}
+
+		m_ptrStorage->remove(uidObject);
+
+		return errCode;
+	}
+
+	// The objects are reference counted, hence one that is removed lives on as long as a lock-free reader still holds it.
+	inline size_t enterEpoch()
+	{
+		return 0;
+	}
+
+	inline void leaveEpoch(size_t nSlot)
+	{
+	}
+
+	// Returns the object only if it is resident; it neither touches the storage (and thus the pending uid updates) nor the LRU order.
+	CacheErrorCode peekObject(const ObjectUIDType uidObject, ObjectTypePtr& ptrObject)
+	{
+		Shard& shard = getShard(uidObject);
+
+#ifdef __CONCURRENT__
+		std::shared_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+		auto it = shard.m_mpObjects.find(uidObject);
+		if (it == shard.m_mpObjects.end())
+		{
+			return CacheErrorCode::KeyDoesNotExist;
+		}
+
+		ptrObject = (*it).second->m_ptrObject;
+		return CacheErrorCode::Success;
+	}
+
+	CacheErrorCode getObject(const ObjectUIDType uidObject, ObjectTypePtr& ptrObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		Shard& shard = getShard(uidObject);
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = shard.m_mpObjects.find(uidObject);
+			if (it != shard.m_mpObjects.end())
+			{
+				shard.moveToFront((*it).second, tick());
+				ptrObject = (*it).second->m_ptrObject;
+				return CacheErrorCode::Success;
+			}
+		}
+
+		std::shared_ptr<Item> ptrItem = loadObject(uidObject, uidUpdated);
+		if (ptrItem == nullptr)
+		{
+			return CacheErrorCode::Error;
+		}
+
+		ptrObject = ptrItem->m_ptrObject;
+		return CacheErrorCode::Success;
+	}
+
+	// Same as getObject for each uid in 'vtUIDs', but the resident objects are looked up under a single acquisition of the
+	// lock of each shard they fall in; only the missing ones go through getObject.
+	CacheErrorCode getObjects(const std::vector<ObjectUIDType>& vtUIDs, std::vector<ObjectTypePtr>& vtObjects, std::vector<std::optional<ObjectUIDType>>& vtUpdatedUIDs)
+	{
+		vtObjects.assign(vtUIDs.size(), nullptr);
+		vtUpdatedUIDs.assign(vtUIDs.size(), std::nullopt);
+
+		std::vector<size_t> vtShardIdx(vtUIDs.size());
+		for (size_t nIdx = 0; nIdx < vtUIDs.size(); nIdx++)
+		{
+			vtShardIdx[nIdx] = getShardIdx(vtUIDs[nIdx]);
+		}
+
+		// Visits the uids shard by shard, in their original order within a shard so that the LRU order comes out the same.
+		std::vector<size_t> vtOrder(vtUIDs.size());
+		std::iota(vtOrder.begin(), vtOrder.end(), 0);
+		std::stable_sort(vtOrder.begin(), vtOrder.end(), [&](size_t lhs, size_t rhs) { return vtShardIdx[lhs] < vtShardIdx[rhs]; });
+
+		std::vector<size_t> vtMissing;
+
+		auto it = vtOrder.begin();
+		while (it != vtOrder.end())
+		{
+			Shard& shard = m_vtShards[vtShardIdx[*it]];
+
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			size_t nShard = vtShardIdx[*it];
+			for (; it != vtOrder.end() && vtShardIdx[*it] == nShard; it++)
+			{
+				auto it_object = shard.m_mpObjects.find(vtUIDs[*it]);
+				if (it_object == shard.m_mpObjects.end())
+				{
+					vtMissing.push_back(*it);
+					continue;
+				}
+
+				shard.moveToFront((*it_object).second, tick());
+				vtObjects[*it] = (*it_object).second->m_ptrObject;
+			}
+		}
+
+		std::sort(vtMissing.begin(), vtMissing.end());
+
+		for (auto it = vtMissing.begin(); it != vtMissing.end(); it++)
+		{
+			CacheErrorCode errCode = getObject(vtUIDs[*it], vtObjects[*it], vtUpdatedUIDs[*it]);
+			if (errCode != CacheErrorCode::Success)
+			{
+				return errCode;
+			}
+		}
+
+		return CacheErrorCode::Success;
+	}
+
+	CacheErrorCode reorder(std::vector<std::pair<ObjectUIDType, ObjectTypePtr>>& vt, bool ensure = true)
+	{
+		while (vt.size() > 0)
+		{
+			// Consecutive nodes of the same shard are reordered under one acquisition of its lock.
+			size_t nShard = getShardIdx(vt.back().first);
+			Shard& shard = m_vtShards[nShard];
+
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			do
+			{
+				auto it = shard.m_mpObjects.find(vt.back().first);
+				if (it != shard.m_mpObjects.end())
+				{
+					shard.moveToFront((*it).second, tick());
+				}
+				else
+				{
+					if (ensure)
+					{
+						throw new std::exception("should not occur!");
+					}
+				}
+
+				vt.pop_back();
+			} while (vt.size() > 0 && getShardIdx(vt.back().first) == nShard);
+		}
+
+		return CacheErrorCode::Success;
+	}
+
+	template <typename Type>
+	CacheErrorCode getObjectOfType(const ObjectUIDType key, Type& ptrObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		Shard& shard = getShard(key);
+
+		std::shared_ptr<Item> ptrItem = nullptr;
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = shard.m_mpObjects.find(key);
+			if (it != shard.m_mpObjects.end())
+			{
+				ptrItem = (*it).second;
+				shard.moveToFront(ptrItem, tick());
+			}
+		}
+
+		if (ptrItem == nullptr)
+		{
+			ptrItem = loadObject(key, uidUpdated);
+			if (ptrItem == nullptr)
+			{
+				return CacheErrorCode::Error;
+			}
+		}
+
+		ptrItem->m_ptrObject->dirty = true; //todo fix it later..
+
+		if (std::holds_alternative<Type>(*ptrItem->m_ptrObject->data))
+		{
+			ptrObject = std::get<Type>(*ptrItem->m_ptrObject->data);
+			return CacheErrorCode::Success;
+		}
+
+		return CacheErrorCode::Error;
+	}
+
+	template<class Type, typename... ArgsType>
+	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, const ArgsType... args)
+	{
+		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
+
+		uidObject = ObjectUIDType::createAddressFromVolatilePointer(reinterpret_cast<uintptr_t>(ptrObject.get()));
+
+		addObject(*uidObject, ptrObject);
+
+		return CacheErrorCode::Success;
+	}
+
+	template<class Type, typename... ArgsType>
+	CacheErrorCode createObjectOfType(std::optional<ObjectUIDType>& uidObject, std::shared_ptr<Type>& ptrCoreObject, const ArgsType... args)
+	{
+		std::shared_ptr<ObjectType> ptrObject = std::make_shared<ObjectType>(std::make_shared<Type>(args...));
+
+		ptrCoreObject = ptrObject->data;
+
+		uidObject = ObjectUIDType::createAddressFromVolatilePointer(reinterpret_cast<uintptr_t>(ptrObject.get()));
+
+		addObject(*uidObject, ptrObject);
+
+		return CacheErrorCode::Success;
+	}
+
+	// See LRUCache::appendObjects.
+	template <typename PrepareCallback>
+	CacheErrorCode appendObjects(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtObjects, PrepareCallback fnPrepare)
+	{
+#ifdef __CONCURRENT__
+		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
+#endif __CONCURRENT__
+
+		size_t nPos = m_ptrStorage->getWritePos();
+
+		fnPrepare(vtObjects, nPos, m_ptrStorage->getBlockSize(), m_ptrStorage->getMediaType());
+
+		return m_ptrStorage->addObjects(vtObjects, nPos);
+	}
+
+	void getCacheState(size_t& lru, size_t& map)
+	{
+		lru = 0;
+		map = 0;
+
+		for (size_t nShard = 0; nShard < SHARDS; nShard++)
+		{
+			Shard& shard = m_vtShards[nShard];
+
+#ifdef __CONCURRENT__
+			std::shared_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			std::shared_ptr<Item> _ptrItem = shard.m_ptrHead;
+			while (_ptrItem != nullptr)
+			{
+				lru++;
+				_ptrItem = _ptrItem->m_ptrNext;
+			}
+
+			map += shard.m_mpObjects.size();
+		}
+	}
+
+private:
+	inline size_t getShardIdx(const ObjectUIDType& uidObject) const
+	{
+		// Volatile uids are addresses whose low bits hardly vary, hence the hash is scrambled and its high half is used.
+		size_t nHash = std::hash<ObjectUIDType>()(uidObject) * 0x9E3779B97F4A7C15ull;
+		return (nHash >> (sizeof(size_t) * 4)) % SHARDS;
+	}
+
+	inline Shard& getShard(const ObjectUIDType& uidObject)
+	{
+		return m_vtShards[getShardIdx(uidObject)];
+	}
+
+	inline uint64_t tick()
+	{
+		return m_nClock.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	inline void addObject(const ObjectUIDType& uidObject, std::shared_ptr<ObjectType> ptrObject)
+	{
+		Shard& shard = getShard(uidObject);
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = shard.m_mpObjects.find(uidObject);
+			if (it != shard.m_mpObjects.end())
+			{
+				(*it).second->m_ptrObject = ptrObject;
+				shard.moveToFront((*it).second, tick());
+			}
+			else
+			{
+				std::shared_ptr<Item> ptrItem = std::make_shared<Item>(uidObject, ptrObject);
+				shard.m_mpObjects[uidObject] = ptrItem;
+				shard.pushToFront(ptrItem, tick());
+			}
+		}
+
+#ifndef __CONCURRENT__
+		flushItemsToStorage();
+#endif __CONCURRENT__
+	}
+
+	// The miss path of getObject: resolves the uid the object was flushed under (waiting for the write if it is still in
+	// progress) and loads it. Note that the object is then cached under its new uid, which may well belong to another shard.
+	std::shared_ptr<Item> loadObject(const ObjectUIDType& uidObject, std::optional<ObjectUIDType>& uidUpdated)
+	{
+		ObjectUIDType _uidUpdated = uidObject;
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
+#endif __CONCURRENT__
+
+			auto it = m_mpUpdatedUIDs.find(uidObject);
+			if (it != m_mpUpdatedUIDs.end())
+			{
+#ifdef __CONCURRENT__
+				std::optional< ObjectUIDType >& _condition = (*it).second.first;
+				cv.wait(lock_storage, [&_condition] { return _condition != std::nullopt; });
+#endif __CONCURRENT__
+
+				uidUpdated = m_mpUpdatedUIDs[uidObject].first;
+
+				assert(uidUpdated != std::nullopt);
+
+				m_mpUpdatedUIDs.erase(uidObject);	// Applied.
+				_uidUpdated = *uidUpdated;
+			}
+		}
+
+		std::shared_ptr<ObjectType> ptrValue = m_ptrStorage->getObject(_uidUpdated);
+		if (ptrValue == nullptr)
+		{
+			return nullptr;
+		}
+
+		Shard& shard = getShard(_uidUpdated);
+
+		std::shared_ptr<Item> ptrItem = nullptr;
+
+		{
+#ifdef __CONCURRENT__
+			std::unique_lock<std::shared_mutex> lock_cache(shard.m_mtxCache);
+#endif __CONCURRENT__
+
+			auto it = shard.m_mpObjects.find(_uidUpdated);
+			if (it != shard.m_mpObjects.end())
+			{
+				// Loaded by another thread in the meantime.
+				shard.moveToFront((*it).second, tick());
+				return (*it).second;
+			}
+
+			ptrItem = std::make_shared<Item>(_uidUpdated, ptrValue);
+			shard.m_mpObjects[_uidUpdated] = ptrItem;
+			shard.pushToFront(ptrItem, tick());
+		}
+
+#ifndef __CONCURRENT__
+		flushItemsToStorage();
+#endif __CONCURRENT__
+
+		return ptrItem;
+	}
+
+	// The shard whose tail was accessed least recently, or nullptr if they are all empty; the shards must be locked.
+	inline Shard* getOldestShard()
+	{
+		Shard* ptrOldest = nullptr;
+		for (size_t nShard = 0; nShard < SHARDS; nShard++)
+		{
+			Shard& shard = m_vtShards[nShard];
+			if (shard.m_ptrTail != nullptr && (ptrOldest == nullptr || shard.m_ptrTail->m_nTick < ptrOldest->m_ptrTail->m_nTick))
+			{
+				ptrOldest = &shard;
+			}
+		}
+
+		return ptrOldest;
+	}
+
+	inline void flushItemsToStorage()
+	{
+#ifdef __CONCURRENT__
+		std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>> vtObjects;
+
+		// Always taken in the same order; this is the only place that holds more than one shard's lock.
+		std::vector<std::unique_lock<std::shared_mutex>> vtLocks;
+		vtLocks.reserve(SHARDS);
+
+		size_t nObjects = 0;
+		for (size_t nShard = 0; nShard < SHARDS; nShard++)
+		{
+			vtLocks.emplace_back(m_vtShards[nShard].m_mtxCache);
+			nObjects += m_vtShards[nShard].m_mpObjects.size();
+		}
+
+		if (nObjects < m_nCacheCapacity)
+			return;
+
+		size_t nFlushCount = nObjects - m_nCacheCapacity;
+
+		if (nFlushCount > FLUSH_COUNT)
+			nFlushCount = FLUSH_COUNT;
+
+		for (size_t idx = 0; idx < nFlushCount; idx++)
+		{
+			Shard* ptrShard = getOldestShard();
+			if (ptrShard == nullptr)
+			{
+				break;
+			}
+
+			// Once the least recently used item is in use, so are the ones accessed after it.
+			if (ptrShard->m_ptrTail->m_ptrObject.use_count() > 1)
+			{
+				break;
+			}
+
+			if (!ptrShard->m_ptrTail->m_ptrObject->mutex.try_lock())
+			{
+				break;
+			}
+			else
+			{
+				ptrShard->m_ptrTail->m_ptrObject->mutex.unlock();
+			}
+
+			std::shared_ptr<Item> ptrItemToFlush = ptrShard->popTail();
+
+			vtObjects.push_back(std::make_pair(ptrItemToFlush->m_uidSelf, std::make_pair(std::nullopt, ptrItemToFlush->m_ptrObject)));
+
+			ptrShard->m_mpObjects.erase(ptrItemToFlush->m_uidSelf);
+		}
+
+		if (vtObjects.size() == 0)
+			return;
+
+		std::unique_lock<std::shared_mutex> lock_storage(m_mtxStorage);
+
+		vtLocks.clear();
+
+		if (m_mpUpdatedUIDs.size() > 0)
+		{
+			m_ptrCallback->applyExistingUpdates(vtObjects, m_mpUpdatedUIDs);
+		}
+
+		// Important: Ensure that no other thread should write to the stroage as the nPos is use to generate the addresses.
+		size_t nPos = m_ptrStorage->getWritePos();
+
+		m_ptrCallback->prepareFlush(vtObjects, nPos, m_ptrStorage->getBlockSize(), m_ptrStorage->getMediaType());
+
+		auto it = vtObjects.begin();
+		while (it != vtObjects.end())
+		{
+			if ((*it).second.second.use_count() != 1)
+			{
+				throw new std::exception("should not occur!");
+			}
+
+			if (m_mpUpdatedUIDs.find((*it).first) != m_mpUpdatedUIDs.end())
+			{
+				throw new std::exception("should not occur!");
+			}
+
+			m_mpUpdatedUIDs[(*it).first] = std::make_pair(std::nullopt, (*it).second.second);
+
+			it++;
+		}
+
+		lock_storage.unlock();
+
+		m_ptrStorage->addObjects(vtObjects, nPos);
+
+		lock_storage.lock();
+
+		it = vtObjects.begin();
+		while (it != vtObjects.end())
+		{
+			auto it_update = m_mpUpdatedUIDs.find((*it).first);
+			if (it_update == m_mpUpdatedUIDs.end())
+			{
+				throw new std::exception("should not occur!");
+			}
+
+			(*it_update).second.first = (*it).second.first;
+
+			it++;
+		}
+
+		lock_storage.unlock();
+
+		cv.notify_all();
+#else
+		size_t nObjects = 0;
+		for (size_t nShard = 0; nShard < SHARDS; nShard++)
+		{
+			nObjects += m_vtShards[nShard].m_mpObjects.size();
+		}
+
+		while (nObjects > m_nCacheCapacity)
+		{
+			Shard* ptrShard = getOldestShard();
+
+			if (ptrShard->m_ptrTail->m_ptrObject.use_count() > 1)
+			{
+				break;
+			}
+
+			std::shared_ptr<Item> ptrTail = ptrShard->m_ptrTail;
+
+			if (ptrTail->m_ptrObject->dirty)
+			{
+				if (m_mpUpdatedUIDs.size() > 0)
+				{
+					m_ptrCallback->applyExistingUpdates(ptrTail->m_ptrObject, m_mpUpdatedUIDs);
+				}
+
+				ObjectUIDType uidUpdated;
+				if (m_ptrStorage->addObject(ptrTail->m_uidSelf, ptrTail->m_ptrObject, uidUpdated) != CacheErrorCode::Success)
+				{
+					throw new std::exception("should not occur!");
+				}
+
+				if (m_mpUpdatedUIDs.find(ptrTail->m_uidSelf) != m_mpUpdatedUIDs.end())
+				{
+					throw new std::exception("should not occur!");
+				}
+
+				m_mpUpdatedUIDs[ptrTail->m_uidSelf] = std::make_pair(uidUpdated, ptrTail->m_ptrObject);
+			}
+
+			ptrShard->m_mpObjects.erase(ptrTail->m_uidSelf);
+			ptrShard->popTail();
+
+			nObjects--;
+		}
+#endif __CONCURRENT__
+	}
+
+#ifdef __CONCURRENT__
+	static void handlerCacheFlush(SelfType* ptrSelf)
+	{
+		do
+		{
+			ptrSelf->flushItemsToStorage();
+
+			std::this_thread::sleep_for(100ms);
+
+		} while (!ptrSelf->m_bStop);
+	}
+#endif __CONCURRENT__
+
+#ifdef __TREE_AWARE_CACHE__
+public:
+	void applyExistingUpdates(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtNodes
+		, std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUpdatedUIDs)
+	{
+
+	}
+
+	void applyExistingUpdates(std::shared_ptr<ObjectType> ptrObject
+		, std::unordered_map<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>& mpUpdatedUIDs)
+	{
+
+	}
+
+	void prepareFlush(std::vector<std::pair<ObjectUIDType, std::pair<std::optional<ObjectUIDType>, std::shared_ptr<ObjectType>>>>& vtObjects
+		, size_t& nOffset, size_t nPointerSize, ObjectUIDType::Media nMediaType)
+	{
+
+	}
+#endif __TREE_AWARE_CACHE__
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+
+// A std::shared_mutex paired with a version counter for optimistic readers. The counter is bumped when the mutex is taken
+// exclusively and again when it is released, hence it is odd while a writer holds it. A reader that samples an even version
+// before reading and finds it unchanged afterwards has not raced with a writer; shared owners leave the counter alone.
+class VersionedSharedMutex
+{
+private:
+	std::shared_mutex m_mutex;
+	std::atomic<uint64_t> m_nVersion;
+
+public:
+	VersionedSharedMutex()
+		: m_nVersion(0)
+	{
+	}
+
+	VersionedSharedMutex(const VersionedSharedMutex&) = delete;
+	VersionedSharedMutex& operator=(const VersionedSharedMutex&) = delete;
+
+	inline void lock()
+	{
+		m_mutex.lock();
+		m_nVersion.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	inline bool try_lock()
+	{
+		if (!m_mutex.try_lock())
+		{
+			return false;
+		}
+
+		m_nVersion.fetch_add(1, std::memory_order_acq_rel);
+		return true;
+	}
+
+	inline void unlock()
+	{
+		m_nVersion.fetch_add(1, std::memory_order_release);
+		m_mutex.unlock();
+	}
+
+	inline void lock_shared()
+	{
+		m_mutex.lock_shared();
+	}
+
+	inline bool try_lock_shared()
+	{
+		return m_mutex.try_lock_shared();
+	}
+
+	inline void unlock_shared()
+	{
+		m_mutex.unlock_shared();
+	}
+
+	// Samples the version ahead of an optimistic read; fails while a writer holds the mutex.
+	inline bool tryReadOptimistic(uint64_t& nVersion) const
+	{
+		nVersion = m_nVersion.load(std::memory_order_acquire);
+		return (nVersion & 1) == 0;
+	}
+
+	// Whether the data read since 'nVersion' was sampled is consistent, i.e. no writer has taken the mutex meanwhile.
+	inline bool validate(uint64_t nVersion) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return m_nVersion.load(std::memory_order_relaxed) == nVersion;
+	}
+};
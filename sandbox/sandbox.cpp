@@ -10,8 +10,11 @@
 
 #include "DataNode.hpp"
 #include "IndexNode.hpp"
+#include "NodeSearch.hpp"
 
 #include <chrono>
+#include <random>
+#include <cmath>
 #include <cassert>
 
 #include "LRUCache.hpp"
@@ -163,7 +166,7 @@ void threaded_test(BPlusStoreType* ptrTree, int degree, int total_entries, int t
 
     }
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[s]" << std::endl;
+    std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[�s]" << std::endl;
     std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::nanoseconds> (end - begin).count() << "[ns]" << std::endl;
 }
 
@@ -278,7 +281,7 @@ void int_test(BPlusStoreType* ptrTree, int degree, int total_entries)
         assert(lru == 1 && map == 1);
     }
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[s]" << std::endl;
+    std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[�s]" << std::endl;
     std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::nanoseconds> (end - begin).count() << "[ns]" << std::endl;
 }
 
@@ -373,7 +376,7 @@ void string_test(BPlusStoreType* ptrTree, int degree, int total_entries)
     }
 
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[s]" << std::endl;
+    std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[�s]" << std::endl;
     std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::nanoseconds> (end - begin).count() << "[ns]" << std::endl;
 }
 
@@ -501,6 +504,152 @@ void test_for_string()
     }
 }
 
+// Lookup cost per node degree of the node search kernels against std::lower_bound.
+template <typename KeyType>
+void node_search_test()
+{
+    std::mt19937 rng(0);
+
+    for (int idx = 4; idx <= 512; idx *= 2) {
+        std::vector<KeyType> vtKeys;
+        for (int nCntr = 0; nCntr < idx; nCntr++)
+        {
+            vtKeys.push_back(nCntr * 2);
+        }
+
+        std::vector<KeyType> vtProbes;
+        for (int nCntr = 0; nCntr < 1000000; nCntr++)
+        {
+            vtProbes.push_back(rng() % (idx * 2));
+        }
+
+        auto fnMeasure = [&](const char* szName, auto fnSearch)
+            {
+                size_t nSum = 0;
+
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                for (const KeyType& key : vtProbes)
+                {
+                    nSum += fnSearch(key);
+                }
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+                std::cout << szName << ": " << (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / vtProbes.size() << "[ns] (" << nSum << ") | ";
+            };
+
+        std::cout << "node_search_test<" << typeid(KeyType).name() << "> idx:" << idx << "| ";
+
+        fnMeasure("std::lower_bound", [&](const KeyType& key) { return std::lower_bound(vtKeys.begin(), vtKeys.end(), key) - vtKeys.begin(); });
+        fnMeasure("linear", [&](const KeyType& key) { return NodeSearch<KeyType>::template linearSearch<false>(vtKeys.data(), vtKeys.size(), key); });
+        fnMeasure("binary", [&](const KeyType& key) { return NodeSearch<KeyType>::template binarySearch<false>(vtKeys.data(), vtKeys.size(), key); });
+        fnMeasure("selected", [&](const KeyType& key) { return NodeSearch<KeyType>::lowerBound(vtKeys.data(), vtKeys.size(), key); });
+
+        std::cout << std::endl;
+    }
+}
+
+#ifdef __TREE_AWARE_CACHE__
+// Replays hot point lookups interleaved with long range scans against a small cache, per replacement policy.
+template <template <typename> typename PolicyType>
+void cache_policy_test(const char* szName, int nTotalEntries, int nHotEntries, int nRounds)
+{
+    typedef int KeyType;
+    typedef int ValueType;
+    typedef ObjectFatUID ObjectUIDType;
+
+    typedef DataNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::DATA_NODE_INT_INT> DataNodeType;
+    typedef IndexNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::INDEX_NODE_INT_INT> IndexNodeType;
+
+    typedef LRUCacheObject<TypeMarshaller, DataNodeType, IndexNodeType> ObjectType;
+    typedef IFlushCallback<ObjectUIDType, ObjectType> ICallback;
+
+    typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, IndexNodeType>, PolicyType>> BPlusStoreType;
+    BPlusStoreType* ptrTree = new BPlusStoreType(16, 200, 1024, 1024 * 1024 * 1024, "D:\\filestore.hdb");
+    ptrTree->template init<DataNodeType>();
+
+    for (int nCntr = 0; nCntr < nTotalEntries; nCntr++)
+    {
+        ptrTree->insert(nCntr, nCntr);
+    }
+
+    std::mt19937 rng(0);
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (int nRound = 0; nRound < nRounds; nRound++)
+    {
+        for (int nCntr = 0; nCntr < 10000; nCntr++)
+        {
+            int nValue = 0;
+            ptrTree->search(rng() % nHotEntries, nValue);
+        }
+
+        int nBegin = rng() % (nTotalEntries / 2);
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        ptrTree->rangeQuery(nBegin, nBegin + nTotalEntries / 2, vtEntries);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    std::cout << "cache_policy_test<" << szName << ">: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
+
+    delete ptrTree;
+}
+
+// Zipf-distributed point lookups against a small cache, per replacement policy. The ranks are spread over the key range so
+// that the hot keys do not share their leaves.
+template <template <typename> typename PolicyType>
+void cache_zipf_test(const char* szName, int nTotalEntries, double dSkew, int nLookups)
+{
+    typedef int KeyType;
+    typedef int ValueType;
+    typedef ObjectFatUID ObjectUIDType;
+
+    typedef DataNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::DATA_NODE_INT_INT> DataNodeType;
+    typedef IndexNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::INDEX_NODE_INT_INT> IndexNodeType;
+
+    typedef LRUCacheObject<TypeMarshaller, DataNodeType, IndexNodeType> ObjectType;
+    typedef IFlushCallback<ObjectUIDType, ObjectType> ICallback;
+
+    typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, IndexNodeType>, PolicyType>> BPlusStoreType;
+    BPlusStoreType* ptrTree = new BPlusStoreType(16, 200, 1024, 1024 * 1024 * 1024, "D:\\filestore.hdb");
+    ptrTree->template init<DataNodeType>();
+
+    for (int nCntr = 0; nCntr < nTotalEntries; nCntr++)
+    {
+        ptrTree->insert(nCntr, nCntr);
+    }
+
+    std::vector<double> vtWeights(nTotalEntries);
+    for (int nRank = 0; nRank < nTotalEntries; nRank++)
+    {
+        vtWeights[nRank] = 1.0 / std::pow(nRank + 1, dSkew);
+    }
+
+    std::mt19937 rng(0);
+    std::discrete_distribution<int> dist(vtWeights.begin(), vtWeights.end());
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (int nCntr = 0; nCntr < nLookups; nCntr++)
+    {
+        int nValue = 0;
+        ptrTree->search((int)(((int64_t)dist(rng) * 7919) % nTotalEntries), nValue);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    std::cout << "cache_zipf_test<" << szName << ">: " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
+
+    std::vector<std::pair<size_t, size_t>> vtStats;
+    ptrTree->getCacheLevelStats(vtStats);
+
+    for (size_t nLevel = 0; nLevel < vtStats.size(); nLevel++)
+    {
+        std::cout << "    level " << nLevel << ": " << vtStats[nLevel].first << " hits, " << vtStats[nLevel].second << " misses" << std::endl;
+    }
+
+    delete ptrTree;
+}
+#endif __TREE_AWARE_CACHE__
+
 void test_for_threaded()
 {
 #ifdef __CONCURRENT__
@@ -571,6 +720,19 @@ int main(int argc, char* argv[])
     test_for_ints();
     test_for_string();
     test_for_threaded();
+    node_search_test<int32_t>();
+    node_search_test<int64_t>();
+
+#ifdef __TREE_AWARE_CACHE__
+    cache_policy_test<LRUPolicy>("LRU", 200000, 2000, 20);
+    cache_policy_test<TwoQPolicy>("2Q", 200000, 2000, 20);
+    cache_policy_test<ARCPolicy>("ARC", 200000, 2000, 20);
+    cache_policy_test<S3FIFOPolicy>("S3-FIFO", 200000, 2000, 20);
+    cache_policy_test<TinyLFUPolicy>("TinyLFU", 200000, 2000, 20);
+
+    cache_zipf_test<LRUPolicy>("LRU", 200000, 0.99, 200000);
+    cache_zipf_test<TinyLFUPolicy>("TinyLFU", 200000, 0.99, 200000);
+#endif __TREE_AWARE_CACHE__
 
     typedef int KeyType;
     typedef int ValueType;
@@ -6,10 +6,17 @@
 #include <variant>
 #include <typeinfo>
 #include <type_traits>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
 
 #include "glog/logging.h"
 
 #include "LRUCache.hpp"
+#include "ShardedLRUCache.hpp"
+#include "ClockCache.hpp"
+#include "CachePolicies.hpp"
 #include "IndexNode.hpp"
 #include "DataNode.hpp"
 #include "BPlusStore.hpp"
@@ -39,6 +46,24 @@ namespace BPlusStore_LRUCache_FileStorage_Suite
 
         typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, InternalNodeType>>> BPlusStoreType;
 
+        // The same tree over nodes that embed their entries, sized for the largest degree the suite runs with.
+        typedef DataNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::DATA_NODE_INT_INT, 64> InlineDataNodeType;
+        typedef IndexNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::INDEX_NODE_INT_INT, 64> InlineInternalNodeType;
+
+        typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, InlineDataNodeType, InlineInternalNodeType>>> InlineBPlusStoreType;
+
+        // The same tree over a cache that is split into shards, each with its own lock, LRU list and flush thread.
+        typedef BPlusStore<ICallback, KeyType, ValueType, ShardedLRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, InternalNodeType>>> ShardedBPlusStoreType;
+
+        // The same tree over a cache that replaces the LRU list with CLOCK.
+        typedef BPlusStore<ICallback, KeyType, ValueType, ClockCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, InternalNodeType>>> ClockBPlusStoreType;
+
+        // The same tree over LRUCache with the scan-resistant replacement policies.
+        typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, InternalNodeType>, TwoQPolicy>> TwoQBPlusStoreType;
+        typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, InternalNodeType>, ARCPolicy>> ARCBPlusStoreType;
+        typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, InternalNodeType>, S3FIFOPolicy>> S3FIFOBPlusStoreType;
+        typedef BPlusStore<ICallback, KeyType, ValueType, LRUCache<ICallback, FileStorage<ICallback, ObjectUIDType, LRUCacheObject, TypeMarshaller, DataNodeType, InternalNodeType>, TinyLFUPolicy>> TinyLFUBPlusStoreType;
+
         BPlusStoreType* m_ptrTree;
 
         void SetUp() override
@@ -288,6 +313,842 @@ namespace BPlusStore_LRUCache_FileStorage_Suite
         delete ptrTree;
     }
 
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Range_Scan_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        ErrorCode code = ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtEntries);
+
+        ASSERT_EQ(code, ErrorCode::Success);
+        ASSERT_EQ(vtEntries.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nIdx = 0; nIdx < vtEntries.size(); nIdx++)
+        {
+            ASSERT_EQ(vtEntries[nIdx].first, nBegin_BulkInsert + nIdx);
+            ASSERT_EQ(vtEntries[nIdx].second, nBegin_BulkInsert + nIdx);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 3)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        int nExpected = nBegin_BulkInsert + 1;
+        ptrTree->scan(nBegin_BulkInsert, nEnd_BulkInsert + 1, [&nExpected, this](const KeyType& key, const ValueType& value)
+            {
+                if ((nExpected - nBegin_BulkInsert) % 3 == 0)
+                {
+                    nExpected++;
+                }
+
+                EXPECT_EQ(key, nExpected);
+                EXPECT_EQ(value, nExpected);
+
+                nExpected++;
+                return true;
+            });
+
+        ASSERT_GE(nExpected, nEnd_BulkInsert);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Cursor_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        BPlusStoreType::Cursor cursor = ptrTree->getCursor();
+
+        ASSERT_EQ(cursor.seek(nBegin_BulkInsert + 1), ErrorCode::Success);
+        ASSERT_EQ(cursor.getKey(), nBegin_BulkInsert + 2);
+
+        for (size_t nCntr = nBegin_BulkInsert + 2; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ASSERT_TRUE(cursor.valid());
+            ASSERT_EQ(cursor.getKey(), nCntr);
+            ASSERT_EQ(cursor.getValue(), nCntr);
+
+            cursor.next();
+        }
+
+        ASSERT_FALSE(cursor.valid());
+
+        ASSERT_EQ(cursor.upper_bound(nEnd_BulkInsert), ErrorCode::KeyDoesNotExist);
+        ASSERT_EQ(cursor.lower_bound(nEnd_BulkInsert - 1), ErrorCode::Success);
+
+        // Interleave structural changes with a backward walk; the cursor must re-seek.
+        for (int nCntr = cursor.getKey(); nCntr >= (int)nBegin_BulkInsert; nCntr = nCntr - 2)
+        {
+            ASSERT_TRUE(cursor.valid());
+            ASSERT_EQ(cursor.getKey(), nCntr);
+
+            ptrTree->insert(nCntr + 1, nCntr + 1);
+
+            cursor.prev();
+        }
+
+        ASSERT_FALSE(cursor.valid());
+        ASSERT_EQ(cursor.prev(), ErrorCode::KeyDoesNotExist);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Bulk_Load_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            vtEntries.push_back(std::make_pair(nCntr, nCntr));
+        }
+
+        ErrorCode code = ptrTree->bulkLoad(vtEntries.begin(), vtEntries.end(), 0.75f);
+        ASSERT_EQ(code, ErrorCode::Success);
+
+        code = ptrTree->bulkLoad(vtEntries.begin(), vtEntries.end());
+        ASSERT_EQ(code, ErrorCode::Error);
+
+        for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtResult;
+        ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtResult);
+
+        ASSERT_EQ(vtResult.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Batch_Insert_Remove_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            vtEntries.push_back(std::make_pair(nCntr, nCntr));
+        }
+
+        std::mt19937 rng(nDegree);
+        std::shuffle(vtEntries.begin(), vtEntries.end(), rng);
+
+        for (size_t nIdx = 0; nIdx < vtEntries.size(); nIdx = nIdx + 1000)
+        {
+            auto itEnd = vtEntries.begin() + std::min(nIdx + 1000, vtEntries.size());
+            ErrorCode code = ptrTree->insertBatch(vtEntries.begin() + nIdx, itEnd);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<KeyType> vtKeys;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            vtKeys.push_back(nCntr);
+        }
+
+        std::shuffle(vtKeys.begin(), vtKeys.end(), rng);
+
+        for (size_t nIdx = 0; nIdx < vtKeys.size(); nIdx = nIdx + 1000)
+        {
+            auto itEnd = vtKeys.begin() + std::min(nIdx + 1000, vtKeys.size());
+            ErrorCode code = ptrTree->removeBatch(vtKeys.begin() + nIdx, itEnd);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        ErrorCode code = ptrTree->removeBatch(vtKeys.begin(), vtKeys.begin() + 1);
+        ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Search_Batch_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::vector<KeyType> vtKeys;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            vtKeys.push_back(nCntr);
+        }
+
+        std::mt19937 rng(nDegree);
+        std::shuffle(vtKeys.begin(), vtKeys.end(), rng);
+
+        std::vector<ValueType> vtValues;
+        std::vector<ErrorCode> vtCodes;
+
+        ErrorCode code = ptrTree->searchBatch(vtKeys, vtValues, vtCodes);
+        ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+
+        for (size_t nIdx = 0; nIdx < vtKeys.size(); nIdx++)
+        {
+            if ((vtKeys[nIdx] - nBegin_BulkInsert) % 2 == 0)
+            {
+                ASSERT_EQ(vtCodes[nIdx], ErrorCode::Success);
+                ASSERT_EQ(vtValues[nIdx], vtKeys[nIdx]);
+            }
+            else
+            {
+                ASSERT_EQ(vtCodes[nIdx], ErrorCode::KeyDoesNotExist);
+            }
+        }
+
+        vtKeys.clear();
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            vtKeys.push_back(nCntr);
+        }
+
+        code = ptrTree->searchBatch(vtKeys, vtValues, vtCodes);
+        ASSERT_EQ(code, ErrorCode::Success);
+
+        for (size_t nIdx = 0; nIdx < vtKeys.size(); nIdx++)
+        {
+            ASSERT_EQ(vtValues[nIdx], vtKeys[nIdx]);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Inline_Node_v1) {
+
+        InlineBPlusStoreType* ptrTree = new InlineBPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<InlineDataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            vtEntries.push_back(std::make_pair(nCntr, nCntr));
+        }
+
+        ErrorCode code = ptrTree->insertBatch(vtEntries.begin(), vtEntries.end());
+        ASSERT_EQ(code, ErrorCode::Success);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Sharded_Cache_v1) {
+
+        ShardedBPlusStoreType* ptrTree = new ShardedBPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Sharded_Cache_v2) {
+
+        // Large enough to keep every node resident, so that the readers below only ever hit the cache.
+        ShardedBPlusStoreType* ptrTree = new ShardedBPlusStoreType(nDegree, nEnd_BulkInsert - nBegin_BulkInsert + 1, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::atomic<size_t> nMismatches = 0;
+        std::vector<std::thread> vtThreads;
+        for (size_t nThread = 0; nThread < 4; nThread++)
+        {
+            vtThreads.push_back(std::thread([&, nThread]() {
+                for (size_t nCntr = nBegin_BulkInsert + nThread; nCntr <= nEnd_BulkInsert; nCntr++)
+                {
+                    int nValue = 0;
+                    if (ptrTree->search(nCntr, nValue) != ErrorCode::Success || nValue != nCntr)
+                    {
+                        nMismatches++;
+                    }
+                }
+            }));
+        }
+
+        for (auto it = vtThreads.begin(); it != vtThreads.end(); it++)
+        {
+            (*it).join();
+        }
+
+        ASSERT_EQ(nMismatches, 0);
+
+        size_t nLRU = 0, nMap = 0;
+        ptrTree->getCacheState(nLRU, nMap);
+
+        ASSERT_EQ(nLRU, nMap);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Clock_Cache_v1) {
+
+        ClockBPlusStoreType* ptrTree = new ClockBPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Clock_Cache_v2) {
+
+        // Large enough to keep every node resident, so that the readers below only ever hit the cache.
+        ClockBPlusStoreType* ptrTree = new ClockBPlusStoreType(nDegree, nEnd_BulkInsert - nBegin_BulkInsert + 1, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::atomic<size_t> nMismatches = 0;
+        std::vector<std::thread> vtThreads;
+        for (size_t nThread = 0; nThread < 4; nThread++)
+        {
+            vtThreads.push_back(std::thread([&, nThread]() {
+                for (size_t nCntr = nBegin_BulkInsert + nThread; nCntr <= nEnd_BulkInsert; nCntr++)
+                {
+                    int nValue = 0;
+                    if (ptrTree->search(nCntr, nValue) != ErrorCode::Success || nValue != nCntr)
+                    {
+                        nMismatches++;
+                    }
+                }
+            }));
+        }
+
+        for (auto it = vtThreads.begin(); it != vtThreads.end(); it++)
+        {
+            (*it).join();
+        }
+
+        ASSERT_EQ(nMismatches, 0);
+
+        size_t nLRU = 0, nMap = 0;
+        ptrTree->getCacheState(nLRU, nMap);
+
+        ASSERT_EQ(nLRU, nMap);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, TwoQ_Policy_v1) {
+
+        TwoQBPlusStoreType* ptrTree = new TwoQBPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        ErrorCode code = ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtEntries);
+
+        ASSERT_EQ(code, ErrorCode::Success);
+        ASSERT_EQ(vtEntries.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, ARC_Policy_v1) {
+
+        ARCBPlusStoreType* ptrTree = new ARCBPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        ErrorCode code = ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtEntries);
+
+        ASSERT_EQ(code, ErrorCode::Success);
+        ASSERT_EQ(vtEntries.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, S3FIFO_Policy_v1) {
+
+        S3FIFOBPlusStoreType* ptrTree = new S3FIFOBPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        ErrorCode code = ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtEntries);
+
+        ASSERT_EQ(code, ErrorCode::Success);
+        ASSERT_EQ(vtEntries.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, TinyLFU_Policy_v1) {
+
+        TinyLFUBPlusStoreType* ptrTree = new TinyLFUBPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        ErrorCode code = ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtEntries);
+
+        ASSERT_EQ(code, ErrorCode::Success);
+        ASSERT_EQ(vtEntries.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Level_Pinning_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<size_t, size_t>> vtStats;
+        ptrTree->getCacheLevelStats(vtStats);
+
+        // The root is pinned from the start, hence it is never loaded; the leaves do not fit into the cache.
+        ASSERT_GT(vtStats.size(), 1);
+        ASSERT_GT(vtStats.front().first, 0);
+        ASSERT_EQ(vtStats.front().second, 0);
+        ASSERT_GT(vtStats.back().second, 0);
+
+        size_t nLRU = 0, nMap = 0;
+        ptrTree->getCacheState(nLRU, nMap);
+
+        ASSERT_EQ(nLRU, nMap);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Byte_Budget_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        // A smaller tree keeps the test short.
+        size_t nLast = std::min<size_t>(nEnd_BulkInsert, nBegin_BulkInsert + 9999);
+        size_t nMiddle = (nBegin_BulkInsert + nLast) / 2;
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nMiddle; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        // Shrink the cache to half of what it holds now, while the tree keeps growing.
+        size_t nBudget = ptrTree->getCacheBytes() / 2;
+        ASSERT_GT(nBudget, 0);
+
+        ptrTree->setCacheCapacityBytes(nBudget);
+
+        for (size_t nCntr = nMiddle + 1; nCntr <= nLast; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nLast; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        for (size_t nRound = 0; nRound < 600 && ptrTree->getCacheBytes() > nBudget; nRound++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        ASSERT_LE(ptrTree->getCacheBytes(), nBudget);
+
+        size_t nLRU = 0, nMap = 0;
+        ptrTree->getCacheState(nLRU, nMap);
+
+        ASSERT_EQ(nLRU, nMap);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Flush_Watermark_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree, nCacheSize, nBlockSize, nFileSize, stFileName);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        // Once the writes stop, the flush drains the cache down to its low watermark on its own.
+        size_t nLRU = 0, nMap = 0;
+        for (size_t nRound = 0; nRound < 100; nRound++)
+        {
+            ptrTree->getCacheState(nLRU, nMap);
+            if (nMap <= nCacheSize)
+            {
+                break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        ASSERT_LE(nMap, nCacheSize);
+        ASSERT_EQ(nLRU, nMap);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        delete ptrTree;
+    }
+
+    // Replays a few hot items interleaved with cold ones, then one long scan, directly against each policy: all but LRU
+    // are to keep the hot items resident throughout the scan. Every miss is a load, as it is for the cache.
+    template <template <typename> typename PolicyType>
+    bool survivesScan(size_t nCapacity)
+    {
+        struct PolicyItem
+        {
+            int m_uidSelf;
+            PolicyItem* m_ptrPrev;
+            PolicyItem* m_ptrNext;
+            uint8_t m_nQueue;
+            uint8_t m_nFrequency;
+        };
+
+        PolicyType<PolicyItem> policy(nCapacity);
+        std::unordered_map<int, std::unique_ptr<PolicyItem>> mpResident;
+
+        auto fnAccess = [&](int uid)
+            {
+                auto it = mpResident.find(uid);
+                if (it != mpResident.end())
+                {
+                    policy.touch((*it).second.get());
+                    return;
+                }
+
+                PolicyItem* ptrItem = new PolicyItem();
+                ptrItem->m_uidSelf = uid;
+                ptrItem->m_nQueue = 0;
+                ptrItem->m_nFrequency = 0;
+
+                mpResident[uid] = std::unique_ptr<PolicyItem>(ptrItem);
+                policy.admit(ptrItem);
+
+                while (mpResident.size() > nCapacity)
+                {
+                    PolicyItem* ptrVictim = policy.victim([](PolicyItem*) { return true; });
+                    policy.evicted(ptrVictim, ptrVictim->m_uidSelf);
+                    mpResident.erase(ptrVictim->m_uidSelf);
+                }
+            };
+
+        int nCold = 1000;
+        for (size_t nRound = 0; nRound < 20; nRound++)
+        {
+            for (int uid = 0; uid < 5; uid++)
+            {
+                fnAccess(uid);
+                fnAccess(uid);
+            }
+
+            fnAccess(nCold++);
+            fnAccess(nCold++);
+        }
+
+        for (size_t nCntr = 0; nCntr < nCapacity * 10; nCntr++)
+        {
+            fnAccess(nCold++);
+        }
+
+        bool bSurvived = true;
+        for (int uid = 0; uid < 5; uid++)
+        {
+            bSurvived = bSurvived && mpResident.find(uid) != mpResident.end();
+        }
+
+        policy.clear();
+        return bSurvived;
+    }
+
+    TEST_P(BPlusStore_LRUCache_FileStorage_Suite_1, Policy_Scan_Resistance_v1) {
+
+        ASSERT_FALSE(survivesScan<LRUPolicy>(nCacheSize / 10));
+        ASSERT_TRUE(survivesScan<TwoQPolicy>(nCacheSize / 10));
+        ASSERT_TRUE(survivesScan<ARCPolicy>(nCacheSize / 10));
+        ASSERT_TRUE(survivesScan<S3FIFOPolicy>(nCacheSize / 10));
+        ASSERT_TRUE(survivesScan<TinyLFUPolicy>(nCacheSize / 10));
+    }
+
     INSTANTIATE_TEST_CASE_P(
         Bulk_Insert_Search_Delete,
         BPlusStore_LRUCache_FileStorage_Suite_1,
@@ -6,6 +6,10 @@
 #include <variant>
 #include <typeinfo>
 #include <type_traits>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
 
 #include "glog/logging.h"
 
@@ -13,6 +17,7 @@
 #include "IndexNode.hpp"
 #include "DataNode.hpp"
 #include "BPlusStore.hpp"
+#include "NodeSearch.hpp"
 #include "NoCacheObject.hpp"
 #include "TypeUID.h"
 
@@ -33,6 +38,12 @@ namespace BPlusStore_NoCache_Suite
 
         typedef BPlusStore<KeyType, ValueType, NoCache<ObjectUIDType, NoCacheObject, DataNodeType, InternalNodeType>> BPlusStoreType;
 
+        // The same tree over nodes that embed their entries, sized for the largest degree the suite runs with.
+        typedef DataNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::DATA_NODE_INT_INT, 64> InlineDataNodeType;
+        typedef IndexNode<KeyType, ValueType, ObjectUIDType, TYPE_UID::INDEX_NODE_INT_INT, 64> InlineInternalNodeType;
+
+        typedef BPlusStore<KeyType, ValueType, NoCache<ObjectUIDType, NoCacheObject, InlineDataNodeType, InlineInternalNodeType>> InlineBPlusStoreType;
+
         BPlusStoreType* m_ptrTree;
 
         void SetUp() override
@@ -278,6 +289,617 @@ namespace BPlusStore_NoCache_Suite
         delete ptrTree;
     }
 
+    TEST_P(BPlusStore_NoCache_Suite_1, Range_Scan_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        ErrorCode code = ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtEntries);
+
+        ASSERT_EQ(code, ErrorCode::Success);
+        ASSERT_EQ(vtEntries.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nIdx = 0; nIdx < vtEntries.size(); nIdx++)
+        {
+            ASSERT_EQ(vtEntries[nIdx].first, nBegin_BulkInsert + nIdx);
+            ASSERT_EQ(vtEntries[nIdx].second, nBegin_BulkInsert + nIdx);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 3)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        int nExpected = nBegin_BulkInsert + 1;
+        ptrTree->scan(nBegin_BulkInsert, nEnd_BulkInsert + 1, [&nExpected, this](const KeyType& key, const ValueType& value)
+            {
+                if ((nExpected - nBegin_BulkInsert) % 3 == 0)
+                {
+                    nExpected++;
+                }
+
+                EXPECT_EQ(key, nExpected);
+                EXPECT_EQ(value, nExpected);
+
+                nExpected++;
+                return true;
+            });
+
+        ASSERT_GE(nExpected, nEnd_BulkInsert);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Cursor_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        BPlusStoreType::Cursor cursor = ptrTree->getCursor();
+
+        ASSERT_EQ(cursor.seek(nBegin_BulkInsert + 1), ErrorCode::Success);
+        ASSERT_EQ(cursor.getKey(), nBegin_BulkInsert + 2);
+
+        for (size_t nCntr = nBegin_BulkInsert + 2; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ASSERT_TRUE(cursor.valid());
+            ASSERT_EQ(cursor.getKey(), nCntr);
+            ASSERT_EQ(cursor.getValue(), nCntr);
+
+            cursor.next();
+        }
+
+        ASSERT_FALSE(cursor.valid());
+
+        ASSERT_EQ(cursor.upper_bound(nEnd_BulkInsert), ErrorCode::KeyDoesNotExist);
+        ASSERT_EQ(cursor.lower_bound(nEnd_BulkInsert - 1), ErrorCode::Success);
+
+        // Interleave structural changes with a backward walk; the cursor must re-seek.
+        for (int nCntr = cursor.getKey(); nCntr >= (int)nBegin_BulkInsert; nCntr = nCntr - 2)
+        {
+            ASSERT_TRUE(cursor.valid());
+            ASSERT_EQ(cursor.getKey(), nCntr);
+
+            ptrTree->insert(nCntr + 1, nCntr + 1);
+
+            cursor.prev();
+        }
+
+        ASSERT_FALSE(cursor.valid());
+        ASSERT_EQ(cursor.prev(), ErrorCode::KeyDoesNotExist);
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Bulk_Load_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            vtEntries.push_back(std::make_pair(nCntr, nCntr));
+        }
+
+        ErrorCode code = ptrTree->bulkLoad(vtEntries.begin(), vtEntries.end(), 0.75f);
+        ASSERT_EQ(code, ErrorCode::Success);
+
+        code = ptrTree->bulkLoad(vtEntries.begin(), vtEntries.end());
+        ASSERT_EQ(code, ErrorCode::Error);
+
+        for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtResult;
+        ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtResult);
+
+        ASSERT_EQ(vtResult.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Batch_Insert_Remove_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            vtEntries.push_back(std::make_pair(nCntr, nCntr));
+        }
+
+        std::mt19937 rng(nDegree);
+        std::shuffle(vtEntries.begin(), vtEntries.end(), rng);
+
+        for (size_t nIdx = 0; nIdx < vtEntries.size(); nIdx = nIdx + 1000)
+        {
+            auto itEnd = vtEntries.begin() + std::min(nIdx + 1000, vtEntries.size());
+            ErrorCode code = ptrTree->insertBatch(vtEntries.begin() + nIdx, itEnd);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<KeyType> vtKeys;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            vtKeys.push_back(nCntr);
+        }
+
+        std::shuffle(vtKeys.begin(), vtKeys.end(), rng);
+
+        for (size_t nIdx = 0; nIdx < vtKeys.size(); nIdx = nIdx + 1000)
+        {
+            auto itEnd = vtKeys.begin() + std::min(nIdx + 1000, vtKeys.size());
+            ErrorCode code = ptrTree->removeBatch(vtKeys.begin() + nIdx, itEnd);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        ErrorCode code = ptrTree->removeBatch(vtKeys.begin(), vtKeys.begin() + 1);
+        ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Search_Batch_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::vector<KeyType> vtKeys;
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            vtKeys.push_back(nCntr);
+        }
+
+        std::mt19937 rng(nDegree);
+        std::shuffle(vtKeys.begin(), vtKeys.end(), rng);
+
+        std::vector<ValueType> vtValues;
+        std::vector<ErrorCode> vtCodes;
+
+        ErrorCode code = ptrTree->searchBatch(vtKeys, vtValues, vtCodes);
+        ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+
+        for (size_t nIdx = 0; nIdx < vtKeys.size(); nIdx++)
+        {
+            if ((vtKeys[nIdx] - nBegin_BulkInsert) % 2 == 0)
+            {
+                ASSERT_EQ(vtCodes[nIdx], ErrorCode::Success);
+                ASSERT_EQ(vtValues[nIdx], vtKeys[nIdx]);
+            }
+            else
+            {
+                ASSERT_EQ(vtCodes[nIdx], ErrorCode::KeyDoesNotExist);
+            }
+        }
+
+        vtKeys.clear();
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            vtKeys.push_back(nCntr);
+        }
+
+        code = ptrTree->searchBatch(vtKeys, vtValues, vtCodes);
+        ASSERT_EQ(code, ErrorCode::Success);
+
+        for (size_t nIdx = 0; nIdx < vtKeys.size(); nIdx++)
+        {
+            ASSERT_EQ(vtValues[nIdx], vtKeys[nIdx]);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Node_Search_v1) {
+
+        auto fnVerify = []<typename Type>(const std::vector<Type>& vtKeys, const std::vector<Type>& vtProbes)
+        {
+            for (const Type& key : vtProbes)
+            {
+                size_t nLower = std::lower_bound(vtKeys.begin(), vtKeys.end(), key) - vtKeys.begin();
+                size_t nUpper = std::upper_bound(vtKeys.begin(), vtKeys.end(), key) - vtKeys.begin();
+
+                ASSERT_EQ(NodeSearch<Type>::lowerBound(vtKeys.data(), vtKeys.size(), key), nLower);
+                ASSERT_EQ(NodeSearch<Type>::upperBound(vtKeys.data(), vtKeys.size(), key), nUpper);
+                ASSERT_EQ(NodeSearch<Type>::template linearSearch<false>(vtKeys.data(), vtKeys.size(), key), nLower);
+                ASSERT_EQ(NodeSearch<Type>::template linearSearch<true>(vtKeys.data(), vtKeys.size(), key), nUpper);
+                ASSERT_EQ(NodeSearch<Type>::template binarySearch<false>(vtKeys.data(), vtKeys.size(), key), nLower);
+                ASSERT_EQ(NodeSearch<Type>::template binarySearch<true>(vtKeys.data(), vtKeys.size(), key), nUpper);
+            }
+        };
+
+        // Spans the sign boundary of the signed compares, with a duplicate every third key.
+        for (int nCount = 0; nCount <= nDegree * 2; nCount++)
+        {
+            std::vector<int32_t> vtInt32, vtProbesInt32;
+            std::vector<uint32_t> vtUInt32, vtProbesUInt32;
+            std::vector<int64_t> vtInt64, vtProbesInt64;
+            std::vector<uint64_t> vtUInt64, vtProbesUInt64;
+            std::vector<double> vtDouble, vtProbesDouble;
+            std::vector<std::string> vtString, vtProbesString;
+
+            for (int nIdx = 0; nIdx < nCount; nIdx++)
+            {
+                int nKey = (nIdx - nCount / 2 - nIdx / 3) * 2;
+
+                vtInt32.push_back(nKey);
+                vtUInt32.push_back((uint32_t)nKey + 0x80000000u);
+                vtInt64.push_back((int64_t)nKey << 33);
+                vtUInt64.push_back(((uint64_t)(int64_t)nKey << 33) + 0x8000000000000000ull);
+                vtDouble.push_back(nKey / 2.0);
+                vtString.push_back(std::to_string(nKey + 1000000));
+            }
+
+            for (int nKey = -nCount - 4; nKey <= nCount + 4; nKey++)
+            {
+                vtProbesInt32.push_back(nKey);
+                vtProbesUInt32.push_back((uint32_t)nKey + 0x80000000u);
+                vtProbesInt64.push_back((int64_t)nKey << 33);
+                vtProbesUInt64.push_back(((uint64_t)(int64_t)nKey << 33) + 0x8000000000000000ull);
+                vtProbesDouble.push_back(nKey / 2.0);
+                vtProbesString.push_back(std::to_string(nKey + 1000000));
+            }
+
+            std::sort(vtString.begin(), vtString.end());
+
+            fnVerify(vtInt32, vtProbesInt32);
+            fnVerify(vtUInt32, vtProbesUInt32);
+            fnVerify(vtInt64, vtProbesInt64);
+            fnVerify(vtUInt64, vtProbesUInt64);
+            fnVerify(vtDouble, vtProbesDouble);
+            fnVerify(vtString, vtProbesString);
+        }
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Inline_Node_v1) {
+
+        InlineBPlusStoreType* ptrTree = new InlineBPlusStoreType(nDegree);
+        ptrTree->template init<InlineDataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+        for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            vtEntries.push_back(std::make_pair(nCntr, nCntr));
+        }
+
+        ErrorCode code = ptrTree->insertBatch(vtEntries.begin(), vtEntries.end());
+        ASSERT_EQ(code, ErrorCode::Success);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            ErrorCode code = ptrTree->remove(nCntr);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+        }
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Optimistic_Search_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        // The odd keys are inserted and removed again while the even ones are looked up, so that the readers run into
+        // splits and merges; the even keys must be found throughout.
+        std::atomic<bool> bDone = false;
+        std::atomic<size_t> nMisses = 0;
+
+        std::thread thWriter([&]()
+            {
+                for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+                {
+                    ptrTree->insert(nCntr, nCntr);
+                }
+
+                for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+                {
+                    ptrTree->remove(nCntr);
+                }
+
+                bDone = true;
+            });
+
+        std::vector<std::thread> vtReaders;
+        for (size_t nReader = 0; nReader < 3; nReader++)
+        {
+            vtReaders.push_back(std::thread([&]()
+                {
+                    do
+                    {
+                        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+                        {
+                            int nValue = 0;
+                            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+                            if (code != ErrorCode::Success || nValue != nCntr)
+                            {
+                                nMisses++;
+                            }
+                        }
+                    } while (!bDone);
+                }));
+        }
+
+        thWriter.join();
+        for (auto it = vtReaders.begin(); it != vtReaders.end(); it++)
+        {
+            (*it).join();
+        }
+
+        ASSERT_EQ(nMisses, 0);
+
+        for (size_t nCntr = nBegin_BulkInsert + 1; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::KeyDoesNotExist);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Concurrent_Insert_v1) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+        {
+            ptrTree->insert(nCntr, nCntr);
+        }
+
+        // Several writers split nodes side by side while the readers look up the keys inserted beforehand, which must be
+        // found throughout.
+        const size_t nWriters = 3;
+        std::atomic<size_t> nActiveWriters = nWriters;
+        std::atomic<size_t> nMisses = 0;
+
+        std::vector<std::thread> vtThreads;
+        for (size_t nWriter = 0; nWriter < nWriters; nWriter++)
+        {
+            vtThreads.push_back(std::thread([&, nWriter]()
+                {
+                    for (size_t nCntr = nBegin_BulkInsert + 1 + nWriter * 2; nCntr <= nEnd_BulkInsert; nCntr = nCntr + nWriters * 2)
+                    {
+                        ptrTree->insert(nCntr, nCntr);
+                    }
+
+                    nActiveWriters--;
+                }));
+        }
+
+        for (size_t nReader = 0; nReader < 2; nReader++)
+        {
+            vtThreads.push_back(std::thread([&]()
+                {
+                    do
+                    {
+                        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr = nCntr + 2)
+                        {
+                            int nValue = 0;
+                            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+                            if (code != ErrorCode::Success || nValue != nCntr)
+                            {
+                                nMisses++;
+                            }
+                        }
+                    } while (nActiveWriters > 0);
+                }));
+        }
+
+        for (auto it = vtThreads.begin(); it != vtThreads.end(); it++)
+        {
+            (*it).join();
+        }
+
+        ASSERT_EQ(nMisses, 0);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtResult;
+        ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtResult);
+
+        ASSERT_EQ(vtResult.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+        for (size_t nIdx = 0; nIdx < vtResult.size(); nIdx++)
+        {
+            ASSERT_EQ(vtResult[nIdx].first, nBegin_BulkInsert + nIdx);
+        }
+
+        delete ptrTree;
+    }
+
+    TEST_P(BPlusStore_NoCache_Suite_1, Concurrent_Insert_v2) {
+
+        BPlusStoreType* ptrTree = new BPlusStoreType(nDegree);
+        ptrTree->template init<DataNodeType>();
+
+        // Every writer owns a quarter of the keys, the last one applying its share in batches, so that they mostly work in
+        // different subtrees of a tree that grows from a single leaf, i.e. whose root is replaced while they run. A scan
+        // runs alongside and must see its keys in ascending order.
+        const size_t nWriters = 4;
+        const size_t nSpan = (nEnd_BulkInsert - nBegin_BulkInsert + 1) / nWriters;
+        std::atomic<size_t> nActiveWriters = nWriters;
+        std::atomic<size_t> nUnordered = 0;
+
+        std::vector<std::thread> vtThreads;
+        for (size_t nWriter = 0; nWriter < nWriters; nWriter++)
+        {
+            vtThreads.push_back(std::thread([&, nWriter]()
+                {
+                    size_t nFirst = nBegin_BulkInsert + nWriter * nSpan;
+                    size_t nLast = nWriter + 1 == nWriters ? nEnd_BulkInsert : nFirst + nSpan - 1;
+
+                    if (nWriter + 1 == nWriters)
+                    {
+                        std::vector<std::pair<KeyType, ValueType>> vtEntries;
+
+                        for (size_t nCntr = nFirst; nCntr <= nLast; nCntr++)
+                        {
+                            vtEntries.push_back(std::make_pair(nCntr, nCntr));
+
+                            if (vtEntries.size() == 1024 || nCntr == nLast)
+                            {
+                                ptrTree->insertBatch(vtEntries.begin(), vtEntries.end());
+                                vtEntries.clear();
+                            }
+                        }
+                    }
+                    else
+                    {
+                        for (size_t nCntr = nFirst; nCntr <= nLast; nCntr++)
+                        {
+                            ptrTree->insert(nCntr, nCntr);
+                        }
+                    }
+
+                    nActiveWriters--;
+                }));
+        }
+
+        vtThreads.push_back(std::thread([&]()
+            {
+                do
+                {
+                    std::vector<std::pair<KeyType, ValueType>> vtResult;
+                    ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtResult);
+
+                    for (size_t nIdx = 1; nIdx < vtResult.size(); nIdx++)
+                    {
+                        if (!(vtResult[nIdx - 1].first < vtResult[nIdx].first))
+                        {
+                            nUnordered++;
+                        }
+                    }
+                } while (nActiveWriters > 0);
+            }));
+
+        for (auto it = vtThreads.begin(); it != vtThreads.end(); it++)
+        {
+            (*it).join();
+        }
+
+        ASSERT_EQ(nUnordered, 0);
+
+        for (size_t nCntr = nBegin_BulkInsert; nCntr <= nEnd_BulkInsert; nCntr++)
+        {
+            int nValue = 0;
+            ErrorCode code = ptrTree->search(nCntr, nValue);
+
+            ASSERT_EQ(code, ErrorCode::Success);
+            ASSERT_EQ(nValue, nCntr);
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> vtResult;
+        ptrTree->rangeQuery(nBegin_BulkInsert, nEnd_BulkInsert + 1, vtResult);
+
+        ASSERT_EQ(vtResult.size(), nEnd_BulkInsert - nBegin_BulkInsert + 1);
+
+        delete ptrTree;
+    }
+
     INSTANTIATE_TEST_CASE_P(
         Bulk_Insert_Search_Delete,
         BPlusStore_NoCache_Suite_1,
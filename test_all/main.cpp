@@ -4,6 +4,7 @@
 
 //#define __CONCURRENT__
 //#define __TREE_AWARE_CACHE__
+//#define __BLINK_TREE__
 
 int main(int argc, char** argv)
 {